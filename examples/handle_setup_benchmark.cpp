@@ -0,0 +1,172 @@
+#include "core/handle_profile.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "loopback_server.hpp"
+
+// per-request handle setup, the way every request used to pay it (reset and
+// the full option set) against a handle profile that is bound once and then
+// only given what differs. the first table times the setup alone, the second
+// adds a keep-alive transfer to the loopback server so the saving can be
+// read against the whole request
+
+static const char* USER_AGENT = CHandleProfile::USER_AGENT;
+
+struct SetupCase {
+	const char* pLabel;
+	bool bMixed;
+	bool bHeaders;
+};
+
+static size_t discardBody(char*, size_t iSize, size_t iNmemb, void*) {
+	return iSize * iNmemb;
+}
+
+static size_t emptyBody(char*, size_t, size_t, void*) {
+	return 0;
+}
+
+static double threadCpuSeconds() {
+	timespec time;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static curl_slist* buildHeaders() {
+	curl_slist* pHeaders = curl_slist_append(nullptr, "Accept: application/json");
+	pHeaders = curl_slist_append(pHeaders, "X-Request-Source: benchmark");
+	return pHeaders;
+}
+
+// what executeHttpRequest did before handle profiles
+static void setupByReset(CURL* pHandle, const std::string& strURL, bool bPost, const std::string& strBody, curl_slist* pHeaders, long iTimeoutMs) {
+	curl_easy_reset(pHandle);
+	curl_easy_setopt(pHandle, CURLOPT_URL, strURL.c_str());
+	curl_easy_setopt(pHandle, CURLOPT_WRITEFUNCTION, discardBody);
+	curl_easy_setopt(pHandle, CURLOPT_WRITEDATA, nullptr);
+	curl_easy_setopt(pHandle, CURLOPT_HEADERFUNCTION, discardBody);
+	curl_easy_setopt(pHandle, CURLOPT_HEADERDATA, nullptr);
+	curl_easy_setopt(pHandle, CURLOPT_TIMEOUT_MS, iTimeoutMs);
+	curl_easy_setopt(pHandle, CURLOPT_CONNECTTIMEOUT_MS, 500L);
+	curl_easy_setopt(pHandle, CURLOPT_TCP_NODELAY, 1L);
+	curl_easy_setopt(pHandle, CURLOPT_TCP_FASTOPEN, 1L);
+	curl_easy_setopt(pHandle, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(pHandle, CURLOPT_MAXREDIRS, 3L);
+	curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYPEER, 0L);
+	curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYHOST, 0L);
+	curl_easy_setopt(pHandle, CURLOPT_USERAGENT, USER_AGENT);
+	curl_easy_setopt(pHandle, CURLOPT_ACCEPT_ENCODING, "");
+	if (bPost) {
+		curl_easy_setopt(pHandle, CURLOPT_POST, 1L);
+		curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, strBody.data());
+		curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, static_cast<long>(strBody.length()));
+	} else {
+		curl_easy_setopt(pHandle, CURLOPT_HTTPGET, 1L);
+	}
+	if (pHeaders) {
+		curl_easy_setopt(pHandle, CURLOPT_HTTPHEADER, pHeaders);
+	}
+}
+
+static void setupByProfile(CURL* pHandle, CHandleState& state, const CHandleProfile& profile, const std::string& strURL, bool bPost, const std::string& strBody, curl_slist* pHeaders) {
+	profile.bind(pHandle, state);
+	curl_easy_setopt(pHandle, CURLOPT_URL, strURL.c_str());
+	curl_easy_setopt(pHandle, CURLOPT_WRITEDATA, nullptr);
+	curl_easy_setopt(pHandle, CURLOPT_HEADERDATA, nullptr);
+	state.setMethod(pHandle, bPost ? HttpMethod::Post : HttpMethod::Get, false);
+	state.setBody(pHandle, strBody, nullptr, static_cast<curl_off_t>(strBody.length()));
+	state.setHeaders(pHandle, pHeaders);
+}
+
+// cpu microseconds per request, with or without the transfer itself
+static double runCase(const SetupCase& setupCase, bool bProfile, bool bPerform, const std::string& strBaseURL, size_t iRequests) {
+	CHandleProfile::Settings settings;
+	settings.timeTimeout = std::chrono::milliseconds(5000);
+	settings.fnWrite = discardBody;
+	settings.fnHeader = discardBody;
+	settings.fnRead = emptyBody;
+	CHandleProfile profile(settings);
+	CHandleState state;
+	
+	CURL* pHandle = curl_easy_init();
+	curl_slist* pHeaders = setupCase.bHeaders ? buildHeaders() : nullptr;
+	std::string strGetURL = strBaseURL + "/items?id=42";
+	std::string strPostURL = strBaseURL + "/orders";
+	std::string strBody = "{\"item\":42,\"quantity\":1}";
+	
+	size_t iFailures = 0;
+	double dStart = 0.0;
+	for (size_t i = 0; i < iRequests + 1; ++i) {
+		// the first request opens the connection and is not counted
+		if (i == 1) {
+			dStart = threadCpuSeconds();
+		}
+		
+		bool bPost = setupCase.bMixed && i % 2 == 1;
+		const std::string& strURL = bPost ? strPostURL : strGetURL;
+		if (bProfile) {
+			setupByProfile(pHandle, state, profile, strURL, bPost, strBody, pHeaders);
+		} else {
+			setupByReset(pHandle, strURL, bPost, strBody, pHeaders, 5000L);
+		}
+		
+		if (bPerform && curl_easy_perform(pHandle) != CURLE_OK) {
+			++iFailures;
+		}
+		state.complete();
+	}
+	double dCpu = threadCpuSeconds() - dStart;
+	
+	curl_slist_free_all(pHeaders);
+	curl_easy_cleanup(pHandle);
+	if (iFailures > 0) {
+		std::cerr << iFailures << " transfers failed" << std::endl;
+	}
+	return dCpu * 1e6 / iRequests;
+}
+
+static void printTable(const char* pTitle, const std::vector<SetupCase>& vecCases, bool bPerform, const std::string& strBaseURL, size_t iRequests) {
+	std::cout << pTitle << std::endl;
+	std::cout << std::left << std::setw(24) << "requests" 
+	          << std::right << std::setw(16) << "reset us/req" 
+	          << std::setw(16) << "profile us/req" 
+	          << std::setw(12) << "saved" << std::endl;
+	
+	for (const SetupCase& setupCase : vecCases) {
+		double dReset = runCase(setupCase, false, bPerform, strBaseURL, iRequests);
+		double dProfile = runCase(setupCase, true, bPerform, strBaseURL, iRequests);
+		std::cout << std::left << std::setw(24) << setupCase.pLabel 
+		          << std::right << std::setw(16) << dReset 
+		          << std::setw(16) << dProfile 
+		          << std::setw(11) << (1.0 - dProfile / dReset) * 100.0 << "%" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+	size_t iSetupRequests = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	size_t iTransferRequests = argc > 2 ? std::stoul(argv[2]) : 20000;
+	
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	CLoopbackServer server(512);
+	
+	std::vector<SetupCase> vecCases = {
+		{"get", false, false},
+		{"get + headers", false, true},
+		{"get/post + headers", true, true}
+	};
+	
+	std::cout << std::fixed << std::setprecision(3);
+	printTable("setup only", vecCases, false, server.getURL(), iSetupRequests);
+	printTable("setup + loopback transfer", vecCases, true, server.getURL(), iTransferRequests);
+	
+	curl_global_cleanup();
+	return 0;
+}
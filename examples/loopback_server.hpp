@@ -0,0 +1,187 @@
+#ifndef HTTP_CLIENT_CPP_EXAMPLES_LOOPBACK_SERVER_H_
+#define HTTP_CLIENT_CPP_EXAMPLES_LOOPBACK_SERVER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// tiny keep-alive HTTP/1.1 server on 127.0.0.1 for the benchmarks. every
+// request gets a fixed body, "/chunked" answers with chunked framing. one
+// thread per connection, which is plenty for a handful of client workers.
+// given a socket path it listens on a unix domain socket instead, a leading
+// '@' puts it in the abstract namespace
+class CLoopbackServer {
+ public:
+	explicit CLoopbackServer(size_t iBodySize = 512) : strBody(iBodySize, 'x') {
+		iListenSocket = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		int iReuse = 1;
+		::setsockopt(iListenSocket, SOL_SOCKET, SO_REUSEADDR, &iReuse, sizeof(iReuse));
+		
+		sockaddr_in address;
+		std::memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = 0;
+		::bind(iListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+		::listen(iListenSocket, 512);
+		
+		socklen_t iLength = sizeof(address);
+		::getsockname(iListenSocket, reinterpret_cast<sockaddr*>(&address), &iLength);
+		iPort = ntohs(address.sin_port);
+		
+		threadAccept = std::thread([this]() { acceptLoop(); });
+	}
+	
+	CLoopbackServer(const std::string& strPath, size_t iBodySize) : strBody(iBodySize, 'x'), strSocketPath(strPath) {
+		iListenSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		
+		sockaddr_un address;
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		std::memcpy(address.sun_path, strPath.data(), std::min(strPath.size(), sizeof(address.sun_path) - 1));
+		socklen_t iLength = sizeof(address);
+		if (isAbstract()) {
+			// abstract names start with a NUL and are exactly as long as given
+			address.sun_path[0] = '\0';
+			iLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + strPath.size());
+		} else {
+			::unlink(strPath.c_str());
+		}
+		::bind(iListenSocket, reinterpret_cast<sockaddr*>(&address), iLength);
+		::listen(iListenSocket, 512);
+		
+		threadAccept = std::thread([this]() { acceptLoop(); });
+	}
+	
+	~CLoopbackServer() {
+		bStopping.store(true);
+		::shutdown(iListenSocket, SHUT_RDWR);
+		threadAccept.join();
+		::close(iListenSocket);
+		if (!strSocketPath.empty() && !isAbstract()) {
+			::unlink(strSocketPath.c_str());
+		}
+		
+		std::lock_guard<std::mutex> lock(mutexConnections);
+		for (int iSocket : vecSockets) {
+			::shutdown(iSocket, SHUT_RDWR);
+		}
+		for (auto& threadConnection : vecConnections) {
+			threadConnection.join();
+		}
+	}
+	
+	unsigned short getPort() const noexcept { return iPort; }
+	std::string getURL() const { return "http://127.0.0.1:" + std::to_string(iPort); }
+	const std::string& getSocketPath() const noexcept { return strSocketPath; }
+	size_t getServedCount() const noexcept { return iServed.load(std::memory_order_relaxed); }
+	
+ private:
+	bool isAbstract() const noexcept { return !strSocketPath.empty() && strSocketPath.front() == '@'; }
+	
+	void acceptLoop() {
+		while (!bStopping.load()) {
+			int iSocket = ::accept4(iListenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+			if (iSocket < 0) {
+				continue;
+			}
+			if (strSocketPath.empty()) {
+				int iNoDelay = 1;
+				::setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iNoDelay, sizeof(iNoDelay));
+			}
+			
+			std::lock_guard<std::mutex> lock(mutexConnections);
+			vecSockets.push_back(iSocket);
+			vecConnections.emplace_back([this, iSocket]() { serveConnection(iSocket); });
+		}
+	}
+	
+	void serveConnection(int iSocket) {
+		std::string strPlain = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " + 
+		                       std::to_string(strBody.size()) + "\r\n\r\n" + strBody;
+		std::string strChunked = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n";
+		for (size_t iOffset = 0; iOffset < strBody.size(); iOffset += 256) {
+			size_t iChunk = std::min<size_t>(256, strBody.size() - iOffset);
+			char arrSize[16];
+			std::snprintf(arrSize, sizeof(arrSize), "%zx\r\n", iChunk);
+			strChunked.append(arrSize).append(strBody, iOffset, iChunk).append("\r\n");
+		}
+		strChunked.append("0\r\n\r\n");
+		
+		std::string strPending;
+		std::vector<char> vecBuffer(64 * 1024);
+		
+		while (true) {
+			ssize_t iReceived = ::recv(iSocket, vecBuffer.data(), vecBuffer.size(), 0);
+			if (iReceived <= 0) {
+				break;
+			}
+			strPending.append(vecBuffer.data(), static_cast<size_t>(iReceived));
+			
+			// answer every complete request in the buffer, bodies are skipped
+			while (true) {
+				size_t iHeadEnd = strPending.find("\r\n\r\n");
+				if (iHeadEnd == std::string::npos) {
+					break;
+				}
+				std::string_view strHead(strPending.data(), iHeadEnd);
+				size_t iContentLength = 0;
+				size_t iLengthPos = findHeader(strHead, "content-length:");
+				if (iLengthPos != std::string_view::npos) {
+					iContentLength = std::strtoul(strHead.data() + iLengthPos + 15, nullptr, 10);
+				}
+				if (strPending.size() < iHeadEnd + 4 + iContentLength) {
+					break;
+				}
+				
+				bool bChunked = strHead.find(" /chunked") != std::string_view::npos;
+				const std::string& strResponse = bChunked ? strChunked : strPlain;
+				if (::send(iSocket, strResponse.data(), strResponse.size(), MSG_NOSIGNAL) < 0) {
+					::close(iSocket);
+					return;
+				}
+				iServed.fetch_add(1, std::memory_order_relaxed);
+				strPending.erase(0, iHeadEnd + 4 + iContentLength);
+			}
+		}
+		::close(iSocket);
+	}
+	
+	static size_t findHeader(std::string_view strHead, std::string_view strName) {
+		for (size_t iPos = strHead.find("\r\n"); iPos != std::string_view::npos; iPos = strHead.find("\r\n", iPos + 2)) {
+			if (strHead.size() - iPos - 2 >= strName.size() && 
+			    strncasecmp(strHead.data() + iPos + 2, strName.data(), strName.size()) == 0) {
+				return iPos + 2;
+			}
+		}
+		return std::string_view::npos;
+	}
+	
+	std::string strBody;
+	std::string strSocketPath;
+	int iListenSocket{-1};
+	unsigned short iPort{0};
+	std::atomic<bool> bStopping{false};
+	std::atomic<size_t> iServed{0};
+	
+	std::thread threadAccept;
+	std::mutex mutexConnections;
+	std::vector<int> vecSockets;
+	std::vector<std::thread> vecConnections;
+};
+
+#endif  // HTTP_CLIENT_CPP_EXAMPLES_LOOPBACK_SERVER_H_
@@ -0,0 +1,96 @@
+#include "core/async_client.hpp"
+
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "loopback_server.hpp"
+
+// compares libcurl against the native HTTP/1.1 transport over loopback
+// keep-alive. the server shares the process, its cpu cost is the same for
+// both runs so the difference in cpu per request belongs to the client
+
+struct BenchmarkResult {
+	double dRequestsPerSecond{0.0};
+	double dCpuMicrosPerRequest{0.0};
+	size_t iFailures{0};
+};
+
+static double processCpuSeconds() {
+	rusage usage;
+	::getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 
+	       (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static BenchmarkResult runBenchmark(const std::string& strURL, const std::string& strEndpoint, bool bNative, size_t iWorkers, size_t iTotalRequests) {
+	CWorkerPool pool(iWorkers);
+	pool.setTimeout(std::chrono::milliseconds(5000));
+	pool.setNativeTransport(bNative);
+	
+	// one warm-up round so both transports start with open connections
+	std::vector<std::future<Response>> vecFutures;
+	for (size_t i = 0; i < iWorkers * 4; ++i) {
+		vecFutures.push_back(pool.getAsync(strURL, strEndpoint));
+	}
+	for (auto& future : vecFutures) {
+		future.get();
+	}
+	vecFutures.clear();
+	vecFutures.reserve(iTotalRequests);
+	
+	double dCpuStart = processCpuSeconds();
+	auto timeStart = std::chrono::steady_clock::now();
+	
+	for (size_t i = 0; i < iTotalRequests; ++i) {
+		vecFutures.push_back(pool.getAsync(strURL, strEndpoint));
+	}
+	
+	BenchmarkResult result;
+	for (auto& future : vecFutures) {
+		Response response = future.get();
+		if (response.iStatusCode != 200) {
+			++result.iFailures;
+		}
+	}
+	
+	double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeStart).count();
+	double dCpu = processCpuSeconds() - dCpuStart;
+	
+	result.dRequestsPerSecond = iTotalRequests / dElapsed;
+	result.dCpuMicrosPerRequest = dCpu * 1e6 / iTotalRequests;
+	return result;
+}
+
+int main(int argc, char** argv) {
+	size_t iTotalRequests = argc > 1 ? std::stoul(argv[1]) : 50000;
+	size_t iWorkers = argc > 2 ? std::stoul(argv[2]) : 4;
+	
+	CLoopbackServer server(512);
+	std::cout << "loopback server on " << server.getURL() << std::endl;
+	std::cout << "requests: " << iTotalRequests << ", workers: " << iWorkers << std::endl << std::endl;
+	
+	std::cout << std::left << std::setw(22) << "transport" 
+	          << std::right << std::setw(14) << "req/s" 
+	          << std::setw(16) << "cpu us/req" 
+	          << std::setw(10) << "failed" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	
+	for (const char* pEndpoint : {"/plain", "/chunked"}) {
+		for (bool bNative : {false, true}) {
+			BenchmarkResult result = runBenchmark(server.getURL(), pEndpoint, bNative, iWorkers, iTotalRequests);
+			std::string strLabel = std::string(bNative ? "native " : "libcurl ") + pEndpoint;
+			std::cout << std::left << std::setw(22) << strLabel 
+			          << std::right << std::setw(14) << result.dRequestsPerSecond 
+			          << std::setw(16) << result.dCpuMicrosPerRequest 
+			          << std::setw(10) << result.iFailures << std::endl;
+		}
+	}
+	
+	return 0;
+}
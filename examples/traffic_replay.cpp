@@ -0,0 +1,858 @@
+#include "core/async_client.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "loopback_server.hpp"
+
+// replays a recorded request log through CWorkerPool. the log is jsonl, one
+// object per line, only "url" is required and "ts" is in seconds:
+//
+//   {"ts": 1712000000.125, "method": "POST", "url": "http://api/v1/items?id=3",
+//    "headers": {"Content-Type": "application/json"}, "body": "{\"a\":1}", "name": "items"}
+//
+// or the binary form written by --to-binary. "name" groups requests in the
+// report, by default they are grouped by method and path. the file is mapped
+// and parsed in place while the replay runs, strings are only copied when
+// they hold escapes or are handed to the client as headers.
+//
+// the scheduler is open loop: each request has an intended send time, taken
+// from the log (scaled by --speed) or from --rate, and goes out then however
+// many earlier requests are still outstanding. latency is measured from the
+// intended time, so a client that stalls shows up in the percentiles instead
+// of quietly lowering the offered load
+
+using ReplayClock = std::chrono::high_resolution_clock;
+
+// binary log: "HCRL", u32 version, then per record a u64 send offset in
+// microseconds and u32 lengths of method, url, headers, body and name
+// followed by their bytes. headers are "Name: value\n" lines
+constexpr char BINARY_LOG_MAGIC[4] = {'H', 'C', 'R', 'L'};
+constexpr std::uint32_t BINARY_LOG_VERSION = 1;
+constexpr size_t BINARY_RECORD_HEADER_SIZE = sizeof(std::uint64_t) + 5 * sizeof(std::uint32_t);
+
+class CMappedLog {
+ public:
+	explicit CMappedLog(const std::string& strPath) {
+		int iFd = ::open(strPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (iFd < 0) {
+			throw std::runtime_error("Failed to open " + strPath + ": " + std::strerror(errno));
+		}
+		
+		struct stat info;
+		if (::fstat(iFd, &info) != 0) {
+			int iError = errno;
+			::close(iFd);
+			throw std::runtime_error("Failed to stat " + strPath + ": " + std::strerror(iError));
+		}
+		
+		iLength = static_cast<size_t>(info.st_size);
+		if (iLength > 0) {
+			pData = ::mmap(nullptr, iLength, PROT_READ, MAP_PRIVATE, iFd, 0);
+			if (pData == MAP_FAILED) {
+				int iError = errno;
+				pData = nullptr;
+				::close(iFd);
+				throw std::runtime_error("Failed to map " + strPath + ": " + std::strerror(iError));
+			}
+			::madvise(pData, iLength, MADV_SEQUENTIAL);
+		}
+		::close(iFd);
+	}
+	
+	~CMappedLog() {
+		if (pData) {
+			::munmap(pData, iLength);
+		}
+	}
+	
+	CMappedLog(const CMappedLog&) = delete;
+	CMappedLog& operator=(const CMappedLog&) = delete;
+	
+	std::string_view getView() const noexcept {
+		return pData ? std::string_view(static_cast<const char*>(pData), iLength) : std::string_view();
+	}
+	
+ private:
+	void* pData{nullptr};
+	size_t iLength{0};
+};
+
+// a string as it appears in the log, decoded only when it holds escapes
+struct LogString {
+	std::string_view strRaw;
+	bool bEscaped{false};
+	
+	bool empty() const noexcept { return strRaw.empty(); }
+	
+	std::string decode() const {
+		if (!bEscaped) {
+			return std::string(strRaw);
+		}
+		
+		std::string strResult;
+		strResult.reserve(strRaw.size());
+		for (size_t i = 0; i < strRaw.size(); ++i) {
+			if (strRaw[i] != '\\' || i + 1 >= strRaw.size()) {
+				strResult.push_back(strRaw[i]);
+				continue;
+			}
+			
+			char cEscape = strRaw[++i];
+			switch (cEscape) {
+				case 'b': strResult.push_back('\b'); break;
+				case 'f': strResult.push_back('\f'); break;
+				case 'n': strResult.push_back('\n'); break;
+				case 'r': strResult.push_back('\r'); break;
+				case 't': strResult.push_back('\t'); break;
+				case 'u': {
+					std::uint32_t iCodePoint = 0;
+					if (!readHex(i + 1, iCodePoint)) {
+						strResult.push_back('?');
+						break;
+					}
+					i += 4;
+					
+					// a high surrogate followed by an escaped low one is a single code point
+					std::uint32_t iLow = 0;
+					if (iCodePoint >= 0xD800 && iCodePoint < 0xDC00 && strRaw.substr(i + 1, 2) == "\\u" &&
+					    readHex(i + 3, iLow) && iLow >= 0xDC00 && iLow < 0xE000) {
+						iCodePoint = 0x10000 + ((iCodePoint - 0xD800) << 10) + (iLow - 0xDC00);
+						i += 6;
+					}
+					appendUtf8(strResult, iCodePoint);
+					break;
+				}
+				default: strResult.push_back(cEscape); break;
+			}
+		}
+		return strResult;
+	}
+	
+ private:
+	bool readHex(size_t iPos, std::uint32_t& iValue) const {
+		if (iPos + 4 > strRaw.size()) {
+			return false;
+		}
+		auto [pEnd, eError] = std::from_chars(strRaw.data() + iPos, strRaw.data() + iPos + 4, iValue, 16);
+		return eError == std::errc() && pEnd == strRaw.data() + iPos + 4;
+	}
+	
+	static void appendUtf8(std::string& strOut, std::uint32_t iCodePoint) {
+		if (iCodePoint < 0x80) {
+			strOut.push_back(static_cast<char>(iCodePoint));
+		} else if (iCodePoint < 0x800) {
+			strOut.push_back(static_cast<char>(0xC0 | (iCodePoint >> 6)));
+			strOut.push_back(static_cast<char>(0x80 | (iCodePoint & 0x3F)));
+		} else if (iCodePoint < 0x10000) {
+			strOut.push_back(static_cast<char>(0xE0 | (iCodePoint >> 12)));
+			strOut.push_back(static_cast<char>(0x80 | ((iCodePoint >> 6) & 0x3F)));
+			strOut.push_back(static_cast<char>(0x80 | (iCodePoint & 0x3F)));
+		} else {
+			strOut.push_back(static_cast<char>(0xF0 | (iCodePoint >> 18)));
+			strOut.push_back(static_cast<char>(0x80 | ((iCodePoint >> 12) & 0x3F)));
+			strOut.push_back(static_cast<char>(0x80 | ((iCodePoint >> 6) & 0x3F)));
+			strOut.push_back(static_cast<char>(0x80 | (iCodePoint & 0x3F)));
+		}
+	}
+};
+
+// every view points into the mapped log
+struct ReplayRecord {
+	double dTimestamp{0.0};
+	bool bHasTimestamp{false};
+	LogString strMethod;
+	LogString strURL;
+	LogString strBody;
+	LogString strName;
+	
+	// a json object for jsonl logs, "Name: value\n" lines for binary ones
+	std::string_view strHeaders;
+	bool bJsonHeaders{false};
+};
+
+// just enough json for flat log records, nothing is copied
+class CJsonCursor {
+ public:
+	explicit CJsonCursor(std::string_view strText) : strText(strText) {}
+	
+	bool consume(char cExpected) {
+		skipSpace();
+		if (iPos < strText.size() && strText[iPos] == cExpected) {
+			++iPos;
+			return true;
+		}
+		return false;
+	}
+	
+	bool readString(LogString& value) {
+		skipSpace();
+		if (iPos >= strText.size() || strText[iPos] != '"') {
+			return false;
+		}
+		
+		size_t iStart = ++iPos;
+		value.bEscaped = false;
+		while (iPos < strText.size()) {
+			char c = strText[iPos];
+			if (c == '\\') {
+				value.bEscaped = true;
+				iPos += 2;
+				continue;
+			}
+			if (c == '"') {
+				value.strRaw = strText.substr(iStart, iPos - iStart);
+				++iPos;
+				return true;
+			}
+			++iPos;
+		}
+		return false;
+	}
+	
+	bool readNumber(double& dValue) {
+		skipSpace();
+		auto [pEnd, eError] = std::from_chars(strText.data() + iPos, strText.data() + strText.size(), dValue);
+		if (eError != std::errc()) {
+			return false;
+		}
+		iPos = static_cast<size_t>(pEnd - strText.data());
+		return true;
+	}
+	
+	// skips one value of any type and returns its text
+	bool skipValue(std::string_view& strValue) {
+		skipSpace();
+		if (iPos >= strText.size()) {
+			return false;
+		}
+		
+		size_t iStart = iPos;
+		char c = strText[iPos];
+		if (c == '"') {
+			LogString ignored;
+			if (!readString(ignored)) {
+				return false;
+			}
+		} else if (c == '{' || c == '[') {
+			int iDepth = 0;
+			while (iPos < strText.size()) {
+				char cCurrent = strText[iPos];
+				if (cCurrent == '"') {
+					LogString ignored;
+					if (!readString(ignored)) {
+						return false;
+					}
+					continue;
+				}
+				++iPos;
+				if (cCurrent == '{' || cCurrent == '[') {
+					++iDepth;
+				} else if ((cCurrent == '}' || cCurrent == ']') && --iDepth == 0) {
+					break;
+				}
+			}
+			if (iDepth != 0) {
+				return false;
+			}
+		} else {
+			while (iPos < strText.size() && strText[iPos] != ',' && strText[iPos] != '}' && strText[iPos] != ']' &&
+			       !std::isspace(static_cast<unsigned char>(strText[iPos]))) {
+				++iPos;
+			}
+		}
+		
+		strValue = strText.substr(iStart, iPos - iStart);
+		return iPos > iStart;
+	}
+	
+ private:
+	void skipSpace() {
+		while (iPos < strText.size() && std::isspace(static_cast<unsigned char>(strText[iPos]))) {
+			++iPos;
+		}
+	}
+	
+	std::string_view strText;
+	size_t iPos{0};
+};
+
+static bool parseJsonRecord(std::string_view strLine, ReplayRecord& record) {
+	record = ReplayRecord();
+	CJsonCursor cursor(strLine);
+	if (!cursor.consume('{') || cursor.consume('}')) {
+		return false;
+	}
+	
+	do {
+		LogString strKey;
+		if (!cursor.readString(strKey) || !cursor.consume(':')) {
+			return false;
+		}
+		
+		bool bParsed = false;
+		std::string_view strIgnored;
+		if (strKey.strRaw == "ts") {
+			bParsed = record.bHasTimestamp = cursor.readNumber(record.dTimestamp);
+		} else if (strKey.strRaw == "method") {
+			bParsed = cursor.readString(record.strMethod);
+		} else if (strKey.strRaw == "url") {
+			bParsed = cursor.readString(record.strURL);
+		} else if (strKey.strRaw == "body") {
+			bParsed = cursor.readString(record.strBody);
+		} else if (strKey.strRaw == "name") {
+			bParsed = cursor.readString(record.strName);
+		} else if (strKey.strRaw == "headers") {
+			bParsed = record.bJsonHeaders = cursor.skipValue(record.strHeaders);
+		} else {
+			bParsed = cursor.skipValue(strIgnored);
+		}
+		if (!bParsed) {
+			return false;
+		}
+	} while (cursor.consume(','));
+	
+	return cursor.consume('}') && !record.strURL.empty();
+}
+
+static bool parseBinaryRecord(std::string_view& strRest, ReplayRecord& record) {
+	if (strRest.size() < BINARY_RECORD_HEADER_SIZE) {
+		return false;
+	}
+	
+	std::uint64_t iOffsetMicros = 0;
+	std::uint32_t arrLengths[5];
+	std::memcpy(&iOffsetMicros, strRest.data(), sizeof(iOffsetMicros));
+	std::memcpy(arrLengths, strRest.data() + sizeof(iOffsetMicros), sizeof(arrLengths));
+	
+	size_t iTotal = BINARY_RECORD_HEADER_SIZE;
+	for (std::uint32_t iLength : arrLengths) {
+		iTotal += iLength;
+	}
+	if (strRest.size() < iTotal) {
+		return false;
+	}
+	
+	record = ReplayRecord();
+	record.dTimestamp = static_cast<double>(iOffsetMicros) / 1e6;
+	record.bHasTimestamp = true;
+	
+	size_t iPos = BINARY_RECORD_HEADER_SIZE;
+	auto take = [&](size_t iIndex) {
+		std::string_view strField = strRest.substr(iPos, arrLengths[iIndex]);
+		iPos += arrLengths[iIndex];
+		return strField;
+	};
+	record.strMethod.strRaw = take(0);
+	record.strURL.strRaw = take(1);
+	record.strHeaders = take(2);
+	record.strBody.strRaw = take(3);
+	record.strName.strRaw = take(4);
+	
+	strRest.remove_prefix(iTotal);
+	return !record.strURL.empty();
+}
+
+static void collectHeaders(const ReplayRecord& record, std::vector<std::pair<std::string, std::string>>& vecHeaders) {
+	vecHeaders.clear();
+	if (record.strHeaders.empty()) {
+		return;
+	}
+	
+	if (record.bJsonHeaders) {
+		CJsonCursor cursor(record.strHeaders);
+		if (!cursor.consume('{') || cursor.consume('}')) {
+			return;
+		}
+		do {
+			LogString strName;
+			LogString strValue;
+			if (!cursor.readString(strName) || !cursor.consume(':') || !cursor.readString(strValue)) {
+				return;
+			}
+			vecHeaders.emplace_back(strName.decode(), strValue.decode());
+		} while (cursor.consume(','));
+		return;
+	}
+	
+	std::string_view strLines = record.strHeaders;
+	while (!strLines.empty()) {
+		size_t iEnd = strLines.find('\n');
+		std::string_view strLine = strLines.substr(0, iEnd);
+		strLines.remove_prefix(iEnd == std::string_view::npos ? strLines.size() : iEnd + 1);
+		
+		size_t iColon = strLine.find(':');
+		if (iColon == std::string_view::npos) {
+			continue;
+		}
+		std::string_view strValue = strLine.substr(iColon + 1);
+		if (!strValue.empty() && strValue.front() == ' ') {
+			strValue.remove_prefix(1);
+		}
+		vecHeaders.emplace_back(std::string(strLine.substr(0, iColon)), std::string(strValue));
+	}
+}
+
+// walks the mapped log one record at a time, malformed lines are counted and skipped
+class CReplayLog {
+ public:
+	explicit CReplayLog(std::string_view strData) : strRest(strData) {
+		if (strRest.size() >= sizeof(BINARY_LOG_MAGIC) + sizeof(std::uint32_t) &&
+		    std::memcmp(strRest.data(), BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) == 0) {
+			std::uint32_t iVersion = 0;
+			std::memcpy(&iVersion, strRest.data() + sizeof(BINARY_LOG_MAGIC), sizeof(iVersion));
+			if (iVersion != BINARY_LOG_VERSION) {
+				throw std::runtime_error("Unsupported binary log version " + std::to_string(iVersion));
+			}
+			bBinary = true;
+			strRest.remove_prefix(sizeof(BINARY_LOG_MAGIC) + sizeof(iVersion));
+		}
+	}
+	
+	bool next(ReplayRecord& record) {
+		if (bBinary) {
+			if (strRest.empty()) {
+				return false;
+			}
+			if (!parseBinaryRecord(strRest, record)) {
+				// a truncated tail, nothing after it can be framed
+				++iSkipped;
+				strRest = {};
+				return false;
+			}
+			return true;
+		}
+		
+		while (!strRest.empty()) {
+			size_t iEnd = strRest.find('\n');
+			std::string_view strLine = strRest.substr(0, iEnd);
+			strRest.remove_prefix(iEnd == std::string_view::npos ? strRest.size() : iEnd + 1);
+			
+			if (!strLine.empty() && strLine.back() == '\r') {
+				strLine.remove_suffix(1);
+			}
+			if (strLine.find_first_not_of(" \t") == std::string_view::npos) {
+				continue;
+			}
+			if (parseJsonRecord(strLine, record)) {
+				return true;
+			}
+			++iSkipped;
+		}
+		return false;
+	}
+	
+	bool isBinary() const noexcept { return bBinary; }
+	size_t getSkipped() const noexcept { return iSkipped; }
+	
+ private:
+	std::string_view strRest;
+	bool bBinary{false};
+	size_t iSkipped{0};
+};
+
+static size_t convertToBinary(CReplayLog& log, const std::string& strPath) {
+	std::ofstream file(strPath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Failed to create " + strPath);
+	}
+	file.write(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+	file.write(reinterpret_cast<const char*>(&BINARY_LOG_VERSION), sizeof(BINARY_LOG_VERSION));
+	
+	ReplayRecord record;
+	std::vector<std::pair<std::string, std::string>> vecHeaders;
+	double dFirst = 0.0;
+	double dOffset = 0.0;
+	bool bFirst = true;
+	size_t iWritten = 0;
+	
+	while (log.next(record)) {
+		if (record.bHasTimestamp) {
+			if (bFirst) {
+				dFirst = record.dTimestamp;
+				bFirst = false;
+			}
+			dOffset = std::max(dOffset, record.dTimestamp - dFirst);
+		}
+		
+		collectHeaders(record, vecHeaders);
+		std::string strHeaders;
+		for (const auto& [strName, strValue] : vecHeaders) {
+			strHeaders.append(strName).append(": ").append(strValue).append(1, '\n');
+		}
+		
+		const std::string arrFields[5] = {record.strMethod.decode(), record.strURL.decode(), strHeaders,
+		                                  record.strBody.decode(), record.strName.decode()};
+		std::uint64_t iOffsetMicros = static_cast<std::uint64_t>(dOffset * 1e6);
+		file.write(reinterpret_cast<const char*>(&iOffsetMicros), sizeof(iOffsetMicros));
+		for (const std::string& strField : arrFields) {
+			std::uint32_t iLength = static_cast<std::uint32_t>(strField.size());
+			file.write(reinterpret_cast<const char*>(&iLength), sizeof(iLength));
+		}
+		for (const std::string& strField : arrFields) {
+			file.write(strField.data(), static_cast<std::streamsize>(strField.size()));
+		}
+		++iWritten;
+	}
+	
+	if (!file.flush()) {
+		throw std::runtime_error("Failed to write " + strPath);
+	}
+	return iWritten;
+}
+
+// "http://host:port/path?query" -> base and endpoint
+static std::pair<std::string_view, std::string_view> splitURL(std::string_view strURL) {
+	size_t iScheme = strURL.find("://");
+	size_t iPath = strURL.find('/', iScheme == std::string_view::npos ? 0 : iScheme + 3);
+	if (iPath == std::string_view::npos) {
+		return {strURL, "/"};
+	}
+	return {strURL.substr(0, iPath), strURL.substr(iPath)};
+}
+
+struct PendingRequest {
+	size_t iEndpoint{0};
+	ReplayClock::time_point timeIntended;
+	std::future<Response> future;
+};
+
+// waits for responses in submission order so the scheduler never blocks on
+// one. latencies come from the response timestamps, so a slow early request
+// does not inflate the ones queued behind it
+class CResponseCollector {
+ public:
+	CResponseCollector() : threadCollector([this]() { run(); }) {}
+	
+	~CResponseCollector() {
+		finish();
+	}
+	
+	void add(PendingRequest pending) {
+		{
+			std::lock_guard<std::mutex> lock(mutexPending);
+			dequePending.push_back(std::move(pending));
+		}
+		conditionPending.notify_one();
+	}
+	
+	// blocks until every added request completed
+	void finish() {
+		{
+			std::lock_guard<std::mutex> lock(mutexPending);
+			bDone = true;
+		}
+		conditionPending.notify_one();
+		if (threadCollector.joinable()) {
+			threadCollector.join();
+		}
+	}
+	
+	std::vector<std::vector<std::uint64_t>>& getLatencies() noexcept { return vecLatencies; }
+	std::vector<size_t>& getErrors() noexcept { return vecErrors; }
+	ReplayClock::time_point getLastResponse() const noexcept { return timeLastResponse; }
+	
+ private:
+	void run() {
+		while (true) {
+			PendingRequest pending;
+			{
+				std::unique_lock<std::mutex> lock(mutexPending);
+				conditionPending.wait(lock, [this]() { return bDone || !dequePending.empty(); });
+				if (dequePending.empty()) {
+					return;
+				}
+				pending = std::move(dequePending.front());
+				dequePending.pop_front();
+			}
+			
+			Response response = pending.future.get();
+			if (pending.iEndpoint >= vecLatencies.size()) {
+				vecLatencies.resize(pending.iEndpoint + 1);
+				vecErrors.resize(pending.iEndpoint + 1);
+			}
+			
+			auto timeLatency = std::chrono::duration_cast<std::chrono::microseconds>(response.timeResponseTime - pending.timeIntended);
+			vecLatencies[pending.iEndpoint].push_back(static_cast<std::uint64_t>(std::max<std::int64_t>(0, timeLatency.count())));
+			if (!response.isSuccess() && !response.isRedirect()) {
+				++vecErrors[pending.iEndpoint];
+			}
+			timeLastResponse = std::max(timeLastResponse, response.timeResponseTime);
+		}
+	}
+	
+	std::mutex mutexPending;
+	std::condition_variable conditionPending;
+	std::deque<PendingRequest> dequePending;
+	bool bDone{false};
+	
+	std::vector<std::vector<std::uint64_t>> vecLatencies;
+	std::vector<size_t> vecErrors;
+	ReplayClock::time_point timeLastResponse;
+	
+	std::thread threadCollector;
+};
+
+struct ReplayOptions {
+	std::string strLogPath;
+	std::string strBinaryOutput;
+	std::string strTarget;
+	bool bLoopback{false};
+	double dSpeed{1.0};
+	double dRate{0.0};
+	size_t iWorkers{4};
+	size_t iLimit{0};
+	std::chrono::milliseconds timeTimeout{5000};
+};
+
+static void printUsage(const char* pProgram) {
+	std::cerr << "usage: " << pProgram << " <log> [options]" << std::endl
+	          << "  --speed X        replay at X times the recorded pace (default 1)" << std::endl
+	          << "  --rate N         ignore timestamps and send N requests per second" << std::endl
+	          << "  --target URL     send everything to URL instead of the recorded hosts" << std::endl
+	          << "  --loopback       start a local stand-in server and target it" << std::endl
+	          << "  --workers N      worker threads (default 4)" << std::endl
+	          << "  --timeout MS     request timeout (default 5000)" << std::endl
+	          << "  --limit N        stop after N requests" << std::endl
+	          << "  --to-binary OUT  write the log in binary form and exit" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, ReplayOptions& options) {
+	if (argc < 2) {
+		return false;
+	}
+	options.strLogPath = argv[1];
+	
+	for (int i = 2; i < argc; ++i) {
+		std::string_view strOption = argv[i];
+		bool bHasValue = i + 1 < argc;
+		if (strOption == "--loopback") {
+			options.bLoopback = true;
+		} else if (!bHasValue) {
+			return false;
+		} else if (strOption == "--speed") {
+			options.dSpeed = std::stod(argv[++i]);
+		} else if (strOption == "--rate") {
+			options.dRate = std::stod(argv[++i]);
+		} else if (strOption == "--target") {
+			options.strTarget = argv[++i];
+		} else if (strOption == "--workers") {
+			options.iWorkers = std::stoul(argv[++i]);
+		} else if (strOption == "--timeout") {
+			options.timeTimeout = std::chrono::milliseconds(std::stoul(argv[++i]));
+		} else if (strOption == "--limit") {
+			options.iLimit = std::stoul(argv[++i]);
+		} else if (strOption == "--to-binary") {
+			options.strBinaryOutput = argv[++i];
+		} else {
+			return false;
+		}
+	}
+	return options.dSpeed > 0.0 && options.dRate >= 0.0 && options.iWorkers > 0;
+}
+
+static std::uint64_t percentile(const std::vector<std::uint64_t>& vecSorted, double dPercentile) {
+	if (vecSorted.empty()) {
+		return 0;
+	}
+	size_t iRank = static_cast<size_t>(dPercentile * static_cast<double>(vecSorted.size()) + 0.999999);
+	return vecSorted[std::clamp<size_t>(iRank, 1, vecSorted.size()) - 1];
+}
+
+int main(int argc, char** argv) {
+	ReplayOptions options;
+	try {
+		if (!parseOptions(argc, argv, options)) {
+			printUsage(argv[0]);
+			return 1;
+		}
+	} catch (const std::exception&) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	
+	try {
+		CMappedLog mappedLog(options.strLogPath);
+		CReplayLog log(mappedLog.getView());
+		
+		if (!options.strBinaryOutput.empty()) {
+			size_t iWritten = convertToBinary(log, options.strBinaryOutput);
+			std::cout << "wrote " << iWritten << " records to " << options.strBinaryOutput
+			          << ", skipped " << log.getSkipped() << std::endl;
+			return 0;
+		}
+		
+		std::unique_ptr<CLoopbackServer> pServer;
+		if (options.bLoopback) {
+			pServer = std::make_unique<CLoopbackServer>(512);
+			options.strTarget = pServer->getURL();
+		}
+		
+		std::cout << "replaying " << options.strLogPath << (log.isBinary() ? " (binary)" : " (jsonl)");
+		if (options.dRate > 0.0) {
+			std::cout << " at " << options.dRate << " req/s";
+		} else {
+			std::cout << " at " << options.dSpeed << "x recorded pace";
+		}
+		if (!options.strTarget.empty()) {
+			std::cout << " against " << options.strTarget;
+		}
+		std::cout << std::endl << std::endl;
+		
+		CWorkerPool pool(options.iWorkers);
+		pool.setTimeout(options.timeTimeout);
+		CResponseCollector collector;
+		
+		std::unordered_map<std::string, size_t, CStringHash, std::equal_to<>> mapEndpoints;
+		std::vector<std::string> vecEndpointNames;
+		std::vector<std::uint64_t> vecLagMicros;
+		std::vector<std::pair<std::string, std::string>> vecHeaders;
+		std::string strKey;
+		
+		ReplayRecord record;
+		size_t iSent = 0;
+		size_t iRejected = 0;
+		double dFirst = 0.0;
+		double dOffset = 0.0;
+		bool bFirst = true;
+		ReplayClock::time_point timeStart = ReplayClock::now();
+		ReplayClock::time_point timeLastIntended = timeStart;
+		
+		while ((options.iLimit == 0 || iSent < options.iLimit) && log.next(record)) {
+			// requests without a timestamp go out together with the previous one
+			if (options.dRate > 0.0) {
+				dOffset = static_cast<double>(iSent) / options.dRate;
+			} else if (record.bHasTimestamp) {
+				if (bFirst) {
+					dFirst = record.dTimestamp;
+					bFirst = false;
+				}
+				dOffset = std::max(dOffset, (record.dTimestamp - dFirst) / options.dSpeed);
+			}
+			auto timeIntended = timeStart + std::chrono::duration_cast<ReplayClock::duration>(std::chrono::duration<double>(dOffset));
+			
+			std::string strURL = record.strURL.decode();
+			auto [strBase, strEndpoint] = splitURL(strURL);
+			std::string strMethod = record.strMethod.empty() ? std::string("GET") : record.strMethod.decode();
+			
+			strKey.clear();
+			if (!record.strName.empty()) {
+				strKey = record.strName.decode();
+			} else {
+				strKey.append(strMethod).append(1, ' ').append(strEndpoint.substr(0, strEndpoint.find('?')));
+			}
+			auto it = mapEndpoints.find(strKey);
+			if (it == mapEndpoints.end()) {
+				it = mapEndpoints.emplace(strKey, vecEndpointNames.size()).first;
+				vecEndpointNames.push_back(strKey);
+			}
+			
+			collectHeaders(record, vecHeaders);
+			
+			// unescaped bodies are sent straight from the mapping, it outlives every request
+			CRequestBody bodyRequest;
+			if (!record.strBody.empty()) {
+				bodyRequest = record.strBody.bEscaped ? CRequestBody::owned(record.strBody.decode()) :
+				                                        CRequestBody::borrowed(record.strBody.strRaw);
+			}
+			
+			// sleep close to the send time and spin the rest, sleeps overshoot
+			auto timeNow = ReplayClock::now();
+			if (timeIntended - timeNow > std::chrono::microseconds(200)) {
+				std::this_thread::sleep_until(timeIntended - std::chrono::microseconds(100));
+			}
+			while (ReplayClock::now() < timeIntended) {
+			}
+			
+			auto timeActual = ReplayClock::now();
+			std::string_view strTarget = options.strTarget.empty() ? strBase : std::string_view(options.strTarget);
+			try {
+				collector.add({it->second, timeIntended, pool.requestAsync(strMethod, strTarget, strEndpoint, vecHeaders, std::move(bodyRequest))});
+			} catch (const std::invalid_argument& e) {
+				// the client refuses what it could never send, count it and move on
+				if (iRejected++ == 0) {
+					std::cerr << "rejected: " << e.what() << std::endl;
+				}
+				continue;
+			}
+			
+			vecLagMicros.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(timeActual - timeIntended).count()));
+			timeLastIntended = timeIntended;
+			++iSent;
+		}
+		
+		collector.finish();
+		
+		double dIntended = std::chrono::duration<double>(timeLastIntended - timeStart).count();
+		double dElapsed = std::chrono::duration<double>(std::max(collector.getLastResponse(), timeStart) - timeStart).count();
+		std::sort(vecLagMicros.begin(), vecLagMicros.end());
+		
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "sent " << iSent << " requests, skipped " << log.getSkipped() << " records, "
+		          << iRejected << " rejected by the client" << std::endl;
+		std::cout << "schedule span " << dIntended << " s, last response after " << dElapsed << " s";
+		if (dIntended > 0.0) {
+			std::cout << ", offered " << iSent / dIntended << " req/s";
+		}
+		std::cout << std::endl;
+		std::cout << "send lag us: p50 " << percentile(vecLagMicros, 0.50)
+		          << ", p99 " << percentile(vecLagMicros, 0.99)
+		          << ", max " << (vecLagMicros.empty() ? 0 : vecLagMicros.back()) << std::endl << std::endl;
+		
+		std::cout << std::left << std::setw(32) << "endpoint (latency ms)"
+		          << std::right << std::setw(9) << "count"
+		          << std::setw(8) << "errors"
+		          << std::setw(9) << "p50"
+		          << std::setw(9) << "p90"
+		          << std::setw(9) << "p99"
+		          << std::setw(9) << "p99.9"
+		          << std::setw(9) << "max" << std::endl;
+		
+		auto& vecLatencies = collector.getLatencies();
+		auto& vecErrors = collector.getErrors();
+		for (size_t i = 0; i < vecLatencies.size(); ++i) {
+			auto& vecSamples = vecLatencies[i];
+			if (vecSamples.empty()) {
+				continue;
+			}
+			std::sort(vecSamples.begin(), vecSamples.end());
+			
+			std::string strLabel = vecEndpointNames[i].size() > 31 ? vecEndpointNames[i].substr(0, 28) + "..." : vecEndpointNames[i];
+			std::cout << std::left << std::setw(32) << strLabel
+			          << std::right << std::setw(9) << vecSamples.size()
+			          << std::setw(8) << vecErrors[i];
+			for (double dPercentile : {0.50, 0.90, 0.99, 0.999}) {
+				std::cout << std::setw(9) << percentile(vecSamples, dPercentile) / 1000.0;
+			}
+			std::cout << std::setw(9) << vecSamples.back() / 1000.0 << std::endl;
+		}
+	} catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+	
+	return 0;
+}
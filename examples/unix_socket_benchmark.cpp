@@ -0,0 +1,104 @@
+#include "core/async_client.hpp"
+
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "loopback_server.hpp"
+
+// compares tcp loopback against a unix domain socket, by path and in the
+// abstract namespace, for a sidecar style upstream on the same host. all
+// three go through libcurl so only the socket family differs
+
+struct BenchmarkResult {
+	double dRequestsPerSecond{0.0};
+	double dCpuMicrosPerRequest{0.0};
+	size_t iFailures{0};
+};
+
+static double processCpuSeconds() {
+	rusage usage;
+	::getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 
+	       (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static BenchmarkResult runBenchmark(const std::string& strURL, const std::string& strSocketPath, size_t iWorkers, size_t iTotalRequests) {
+	CWorkerPool pool(iWorkers);
+	pool.setTimeout(std::chrono::milliseconds(5000));
+	if (!strSocketPath.empty()) {
+		pool.setUnixSocket(CUtils::extractHost(strURL), strSocketPath);
+	}
+	
+	// one warm-up round so every run starts with open connections
+	std::vector<std::future<Response>> vecFutures;
+	for (size_t i = 0; i < iWorkers * 4; ++i) {
+		vecFutures.push_back(pool.getAsync(strURL, "/plain"));
+	}
+	for (auto& future : vecFutures) {
+		future.get();
+	}
+	vecFutures.clear();
+	vecFutures.reserve(iTotalRequests);
+	
+	double dCpuStart = processCpuSeconds();
+	auto timeStart = std::chrono::steady_clock::now();
+	
+	for (size_t i = 0; i < iTotalRequests; ++i) {
+		vecFutures.push_back(pool.getAsync(strURL, "/plain"));
+	}
+	
+	BenchmarkResult result;
+	for (auto& future : vecFutures) {
+		Response response = future.get();
+		if (response.iStatusCode != 200) {
+			++result.iFailures;
+		}
+	}
+	
+	double dElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeStart).count();
+	double dCpu = processCpuSeconds() - dCpuStart;
+	
+	result.dRequestsPerSecond = iTotalRequests / dElapsed;
+	result.dCpuMicrosPerRequest = dCpu * 1e6 / iTotalRequests;
+	return result;
+}
+
+static void printResult(const std::string& strLabel, const BenchmarkResult& result) {
+	std::cout << std::left << std::setw(22) << strLabel 
+	          << std::right << std::setw(14) << result.dRequestsPerSecond 
+	          << std::setw(16) << result.dCpuMicrosPerRequest 
+	          << std::setw(10) << result.iFailures << std::endl;
+}
+
+int main(int argc, char** argv) {
+	size_t iTotalRequests = argc > 1 ? std::stoul(argv[1]) : 50000;
+	size_t iWorkers = argc > 2 ? std::stoul(argv[2]) : 4;
+	
+	std::string strSuffix = std::to_string(::getpid());
+	CLoopbackServer serverTcp(512);
+	CLoopbackServer serverPath("/tmp/http_client_bench_" + strSuffix + ".sock", 512);
+	CLoopbackServer serverAbstract("@http_client_bench_" + strSuffix, 512);
+	
+	std::cout << "tcp server on " << serverTcp.getURL() << std::endl;
+	std::cout << "unix servers on " << serverPath.getSocketPath() << " and " << serverAbstract.getSocketPath() << std::endl;
+	std::cout << "requests: " << iTotalRequests << ", workers: " << iWorkers << std::endl << std::endl;
+	
+	std::cout << std::left << std::setw(22) << "transport" 
+	          << std::right << std::setw(14) << "req/s" 
+	          << std::setw(16) << "cpu us/req" 
+	          << std::setw(10) << "failed" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	
+	printResult("tcp loopback", runBenchmark(serverTcp.getURL(), "", iWorkers, iTotalRequests));
+	printResult("unix path", runBenchmark("http://sidecar", serverPath.getSocketPath(), iWorkers, iTotalRequests));
+	printResult("unix abstract", runBenchmark("http://sidecar", serverAbstract.getSocketPath(), iWorkers, iTotalRequests));
+	
+	return 0;
+}
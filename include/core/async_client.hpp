@@ -1,31 +1,62 @@
 #ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_ASYNC_CLIENT_H_
 #define HTTP_CLIENT_CPP_INCLUDE_CORE_ASYNC_CLIENT_H_
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <curl/curl.h>
 
+#include "core/buffer_pool.hpp"
+#include "core/cancellation.hpp"
+#include "core/handle_profile.hpp"
+#include "core/intern_pool.hpp"
+#include "core/profiler.hpp"
+#include "core/request_body.hpp"
 #include "utils/utils.hpp"
 
+// why a response was produced locally instead of by the server
+enum class ResponseError : std::uint8_t {
+	None,
+	Timeout,
+	ConnectFailed,
+	TlsFailed,
+	TransportFailed,
+	QueueFull,
+	CircuitOpen,
+	Cancelled
+};
+
 struct Response {
 	unsigned int iStatusCode{0};
+	ResponseError eError{ResponseError::None};
 	std::string strBody;
 	std::vector<std::pair<std::string, std::string>> vecHeaders;
 	
 	std::chrono::high_resolution_clock::time_point timeRequestTime;
 	std::chrono::high_resolution_clock::time_point timeResponseTime;
 	
+	bool bFromCache{false};
+	
+	// worker pool the body and header buffers came from, they go back there
+	// when the response is destroyed
+	std::shared_ptr<CBufferPool> pBufferPool;
+	
 	constexpr bool isSuccess() const noexcept {
 		return CUtils::isSuccessStatusCode(iStatusCode);
 	}
@@ -49,33 +80,78 @@ struct Response {
 	Response& operator=(const Response&) = default;
 	Response(Response&&) = default;
 	Response& operator=(Response&&) = default;
+	
+	~Response() {
+		if (pBufferPool) {
+			pBufferPool->release(std::move(strBody));
+			pBufferPool->release(std::move(vecHeaders));
+		}
+	}
 };
 
+class CUpstreamGroup;
+
 struct Request {
-	std::string strURL;
-	std::string strEndpoint;
-	std::vector<std::pair<std::string, std::string>> vecHeaders;
-	std::string strMethod;
-	std::string strBody;
+	HttpMethod eMethod{HttpMethod::Get};
+	
+	// base urls and header sets are interned, requests to the same upstream
+	// share one refcounted copy
+	std::shared_ptr<const std::string> pBaseURL;
+	std::shared_ptr<const std::vector<std::pair<std::string, std::string>>> pHeaders;
+	
+	// endpoint followed by the copied body, if any, in a single allocation
+	std::unique_ptr<char[]> pStrings;
+	std::uint32_t iEndpointLength{0};
+	
+	CRequestBody bodyRequest;
+	
+	// set for requests addressed to an upstream group, the base url is then
+	// empty and the worker picks the endpoint
+	std::shared_ptr<CUpstreamGroup> pUpstreamGroup;
+	
+	CCancellationToken tokenCancel;
 	
 	std::chrono::high_resolution_clock::time_point timeRequestTime;
 	std::promise<Response> promiseResponse;
 	
-	template<typename StringType1, typename StringType2, typename StringType3, typename StringType4>
-	Request(StringType1&& strURL, StringType2&& strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, StringType3&& strMethod, StringType4&& strBody) : strURL(std::forward<StringType1>(strURL)), strEndpoint(std::forward<StringType2>(strEndpoint)), vecHeaders(vecHeaders), strMethod(std::forward<StringType3>(strMethod)), strBody(std::forward<StringType4>(strBody)), timeRequestTime(std::chrono::high_resolution_clock::now()), promiseResponse(std::promise<Response>{}) {}
+	// runs on the worker right before the promise is fulfilled
+	std::function<void(const Request&, Response&)> fnOnComplete;
+	
+	Request() = default;
+	Request(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, HttpMethod eMethod, std::string_view strBody = {});
+	Request(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, HttpMethod eMethod, CRequestBody bodyRequest);
 	
 	Request(Request&&) = default;
 	Request& operator=(Request&&) = default;
 	Request(const Request&) = delete;
 	Request& operator=(const Request&) = delete;
 	~Request() = default;
+	
+	std::string_view getURL() const noexcept {
+		return pBaseURL ? std::string_view(*pBaseURL) : std::string_view();
+	}
+	
+	std::string_view getEndpoint() const noexcept {
+		return std::string_view(pStrings.get(), iEndpointLength);
+	}
+	
+	std::string_view getMethodName() const noexcept {
+		return CUtils::httpMethodName(eMethod);
+	}
+	
+	const std::vector<std::pair<std::string, std::string>>& getHeaders() const noexcept;
+	void setHeaders(const std::vector<std::pair<std::string, std::string>>& vecHeaders);
+	
+	static size_t getInternedURLCount();
+	static size_t getInternedHeaderSetCount();
 };
 
 class CFastQueue {
  private:
 	std::queue<Request> queueRequests;
-	mutable std::mutex mutexQueue;
+	mutable CInstrumentedMutex mutexQueue;
 	std::condition_variable conditionQueue;
+	CHotPathProfiler* pProfiler{nullptr};
 	
  public:
 	CFastQueue() = default;
@@ -85,30 +161,45 @@ class CFastQueue {
 	CFastQueue& operator=(const CFastQueue&) = delete;
 	
 	CFastQueue(CFastQueue&& other) noexcept {
-		std::lock_guard<std::mutex> lock(other.mutexQueue);
+		std::lock_guard<CInstrumentedMutex> lock(other.mutexQueue);
 		queueRequests = std::move(other.queueRequests);
 	}
 	
 	CFastQueue& operator=(CFastQueue&& other) noexcept {
 		if (this != &other) {
 			std::lock(mutexQueue, other.mutexQueue);
-			std::lock_guard<std::mutex> lock1(mutexQueue, std::adopt_lock);
-			std::lock_guard<std::mutex> lock2(other.mutexQueue, std::adopt_lock);
+			std::lock_guard<CInstrumentedMutex> lock1(mutexQueue, std::adopt_lock);
+			std::lock_guard<CInstrumentedMutex> lock2(other.mutexQueue, std::adopt_lock);
 			queueRequests = std::move(other.queueRequests);
 		}
 		return *this;
 	}
 	
+	// set before any thread touches the queue
+	void setProfiler(CHotPathProfiler* pProfiler) noexcept {
+		this->pProfiler = pProfiler;
+		mutexQueue.attach(pProfiler);
+	}
+	
+	LockStats getLockStats(std::string strName) const {
+		return mutexQueue.getStats(std::move(strName));
+	}
+	
+	void resetLockStats() noexcept {
+		mutexQueue.resetStats();
+	}
+	
 	void enqueue(Request requestItem) {
+		CStageTimer timerEnqueue(pProfiler, ProfileStage::Enqueue);
 		{
-			std::lock_guard<std::mutex> lock(mutexQueue);
+			std::lock_guard<CInstrumentedMutex> lock(mutexQueue);
 			queueRequests.push(std::move(requestItem));
 		}
 		conditionQueue.notify_one();
 	}
 	
 	bool dequeue(Request& resultRequest) {
-		std::unique_lock<std::mutex> lock(mutexQueue);
+		std::lock_guard<CInstrumentedMutex> lock(mutexQueue);
 		if (queueRequests.empty()) {
 			return false;
 		}
@@ -118,22 +209,37 @@ class CFastQueue {
 	}
 	
 	bool dequeue_wait(Request& resultRequest, std::chrono::milliseconds timeout = std::chrono::milliseconds(1)) {
-		std::unique_lock<std::mutex> lock(mutexQueue);
-		if (conditionQueue.wait_for(lock, timeout, [this] { return !queueRequests.empty(); })) {
-			resultRequest = std::move(queueRequests.front());
-			queueRequests.pop();
-			return true;
+		std::uint64_t iStart = pProfiler && pProfiler->shouldSample() ? CHotPathProfiler::readCycles() : 0;
+		
+		// taken through the instrumented lock, waited on as the plain mutex
+		mutexQueue.lock();
+		std::unique_lock<std::mutex> lock(mutexQueue.native(), std::adopt_lock);
+		if (queueRequests.empty()) {
+			if (!conditionQueue.wait_for(lock, timeout, [this] { return !queueRequests.empty(); })) {
+				return false;
+			}
+			// time spent idle on an empty queue is not dequeue cost
+			if (iStart != 0) {
+				iStart = CHotPathProfiler::readCycles();
+			}
 		}
-		return false;
+		resultRequest = std::move(queueRequests.front());
+		queueRequests.pop();
+		lock.unlock();
+		
+		if (iStart != 0) {
+			pProfiler->record(ProfileStage::Dequeue, CHotPathProfiler::readCycles() - iStart);
+		}
+		return true;
 	}
 	
 	bool empty() const noexcept {
-		std::lock_guard<std::mutex> lock(mutexQueue);
+		std::lock_guard<CInstrumentedMutex> lock(mutexQueue);
 		return queueRequests.empty();
 	}
 	
 	size_t size() const noexcept {
-		std::lock_guard<std::mutex> lock(mutexQueue);
+		std::lock_guard<CInstrumentedMutex> lock(mutexQueue);
 		return queueRequests.size();
 	}
 };
@@ -145,6 +251,7 @@ class CConnectionPool {
 		std::string strHost;
 		std::chrono::high_resolution_clock::time_point timeLastUsed;
 		bool bInUse{false};
+		CHandleState state;
 		
 		Connection() = default;
 		~Connection() {
@@ -161,6 +268,7 @@ class CConnectionPool {
 			, strHost(std::move(other.strHost))
 			, timeLastUsed(other.timeLastUsed)
 			, bInUse(other.bInUse)
+			, state(std::move(other.state))
 		{
 			other.pHandle = nullptr;
 		}
@@ -174,6 +282,7 @@ class CConnectionPool {
 				strHost = std::move(other.strHost);
 				timeLastUsed = other.timeLastUsed;
 				bInUse = other.bInUse;
+				state = std::move(other.state);
 				other.pHandle = nullptr;
 			}
 			return *this;
@@ -185,57 +294,148 @@ class CConnectionPool {
 	static constexpr size_t MAX_TOTAL_CONNECTIONS = 500;   
 	
 	std::vector<std::unique_ptr<Connection>> vecConnections;
-	std::mutex mutexConnections;
+	CInstrumentedMutex mutexConnections;
 	std::atomic<size_t> iTotalConnections{0};
+	CURLSH* pShare{nullptr};
 	
- public:
-	CConnectionPool() {
-		vecConnections.reserve(MAX_TOTAL_CONNECTIONS);
+	std::unique_ptr<Connection> createConnection(const std::string& strHost) {
+		auto pConn = std::make_unique<Connection>();
+		pConn->pHandle = curl_easy_init();
+		if (!pConn->pHandle) {
+			return nullptr;
+		}
+		if (pShare) {
+			curl_easy_setopt(pConn->pHandle, CURLOPT_SHARE, pShare);
+		}
+		pConn->strHost = strHost;
+		pConn->bInUse = true;
+		pConn->timeLastUsed = std::chrono::high_resolution_clock::now();
+		return pConn;
 	}
 	
-	~CConnectionPool() = default;
+	static size_t discardData(char*, size_t iSize, size_t iNmemb, void*) {
+		return iSize * iNmemb;
+	}
 	
-	CURL* getConnection(const std::string& strHost) {
-		std::lock_guard<std::mutex> lock(mutexConnections);
-		
+	// caller holds mutexConnections
+	Connection* checkout(const std::string& strHost) {
 		for (auto& pConn : vecConnections) {
 			if (!pConn->bInUse && pConn->strHost == strHost) {
 				pConn->bInUse = true;
 				pConn->timeLastUsed = std::chrono::high_resolution_clock::now();
-				return pConn->pHandle;
+				return pConn.get();
 			}
 		}
 		
 		if (iTotalConnections.load() < MAX_TOTAL_CONNECTIONS) {
-			auto pConn = std::make_unique<Connection>();
-			pConn->pHandle = curl_easy_init();
-			pConn->strHost = strHost;
-			pConn->bInUse = true;
-			pConn->timeLastUsed = std::chrono::high_resolution_clock::now();
-			
-			curl_easy_setopt(pConn->pHandle, CURLOPT_TCP_NODELAY, 1L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_TCP_FASTOPEN, 1L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_MAXREDIRS, 3L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_FOLLOWLOCATION, 1L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_SSL_VERIFYPEER, 0L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_SSL_VERIFYHOST, 0L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_TIMEOUT_MS, 1000L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_CONNECTTIMEOUT_MS, 500L);
-			curl_easy_setopt(pConn->pHandle, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
+			auto pConn = createConnection(strHost);
+			if (!pConn) {
+				return nullptr;
+			}
 			
-			CURL* pHandle = pConn->pHandle;
+			Connection* pCreated = pConn.get();
 			vecConnections.push_back(std::move(pConn));
 			iTotalConnections.fetch_add(1);
-			return pHandle;
+			return pCreated;
 		}
 		
 		return nullptr;
 	}
 	
+ public:
+	// a handle checked out for one request. the destructor hands it back to
+	// the pool, or cleans it up when the pool was full and it was made just
+	// for this request
+	class Lease {
+	 public:
+		Lease() = default;
+		~Lease() { release(); }
+		
+		Lease(Lease&& other) noexcept
+			: pPool(std::exchange(other.pPool, nullptr))
+			, pConnection(std::exchange(other.pConnection, nullptr))
+			, pDetached(std::move(other.pDetached))
+		{}
+		
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		Lease& operator=(Lease&&) = delete;
+		
+		explicit operator bool() const noexcept { return pConnection != nullptr; }
+		CURL* get() const noexcept { return pConnection->pHandle; }
+		CHandleState& getState() const noexcept { return pConnection->state; }
+		bool isDetached() const noexcept { return pDetached != nullptr; }
+	
+	 private:
+		friend class CConnectionPool;
+		
+		void release() noexcept {
+			if (pPool && pConnection) {
+				pPool->returnConnection(pConnection->pHandle);
+			}
+			pPool = nullptr;
+			pConnection = nullptr;
+			pDetached.reset();
+		}
+		
+		CConnectionPool* pPool{nullptr};
+		Connection* pConnection{nullptr};
+		std::unique_ptr<Connection> pDetached;
+	};
+	
+	
+	CConnectionPool() {
+		vecConnections.reserve(MAX_TOTAL_CONNECTIONS);
+	}
+	
+	~CConnectionPool() = default;
+	
+	// handles created from now on join the share, which has to outlive the pool
+	void setShare(CURLSH* pShare) noexcept {
+		std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+		this->pShare = pShare;
+	}
+	
+	// set before any thread touches the pool
+	void setProfiler(const CHotPathProfiler* pProfiler) noexcept {
+		mutexConnections.attach(pProfiler);
+	}
+	
+	LockStats getLockStats(std::string strName) const {
+		return mutexConnections.getStats(std::move(strName));
+	}
+	
+	void resetLockStats() noexcept {
+		mutexConnections.resetStats();
+	}
+	
+	CURL* getConnection(const std::string& strHost) {
+		std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+		Connection* pConn = checkout(strHost);
+		return pConn ? pConn->pHandle : nullptr;
+	}
+	
+	// a pooled handle for strHost, or a detached one when the pool is full.
+	// the lease is empty only when curl could not create a handle at all
+	Lease acquire(const std::string& strHost) {
+		Lease lease;
+		std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+		
+		if (Connection* pConn = checkout(strHost)) {
+			lease.pPool = this;
+			lease.pConnection = pConn;
+			return lease;
+		}
+		
+		lease.pDetached = createConnection(strHost);
+		lease.pConnection = lease.pDetached.get();
+		return lease;
+	}
+	
 	void returnConnection(CURL* pHandle) {
 		if (!pHandle) return;
 		
-		std::lock_guard<std::mutex> lock(mutexConnections);
+		std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
 		for (auto& pConn : vecConnections) {
 			if (pConn->pHandle == pHandle) {
 				pConn->bInUse = false;
@@ -244,11 +444,182 @@ class CConnectionPool {
 			}
 		}
 	}
+	
+	// handles are keyed by authority, and by socket too when the connection
+	// goes over a unix domain socket instead of tcp
+	static std::string buildKey(std::string_view strAuthority, std::string_view strUnixSocket) {
+		if (strUnixSocket.empty()) {
+			return std::string(strAuthority);
+		}
+		std::string strKey;
+		strKey.reserve(strUnixSocket.size() + strAuthority.size() + 6);
+		strKey.append("unix:").append(strUnixSocket).append(1, '|').append(strAuthority);
+		return strKey;
+	}
+	
+	// opens up to iCount additional keep-alive connections to strHost by running a
+	// body-less request against strURL on each, so the dns, tcp and tls setup is
+	// already paid when real traffic arrives. blocks until all handshakes finish
+	size_t prewarm(const std::string& strHost, const std::string& strURL, size_t iCount, const CHandleProfile& profile, std::string_view strUnixSocket = {}) {
+		std::vector<Connection*> vecHandles;
+		{
+			std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+			
+			size_t iHostConnections = 0;
+			for (const auto& pConn : vecConnections) {
+				if (pConn->strHost == strHost) {
+					++iHostConnections;
+				}
+			}
+			
+			while (vecHandles.size() < iCount && 
+			       iHostConnections < MAX_CONNECTIONS_PER_HOST && 
+			       iTotalConnections.load() < MAX_TOTAL_CONNECTIONS) {
+				auto pConn = createConnection(strHost);
+				if (!pConn) {
+					break;
+				}
+				vecHandles.push_back(pConn.get());
+				vecConnections.push_back(std::move(pConn));
+				iTotalConnections.fetch_add(1);
+				++iHostConnections;
+			}
+		}
+		
+		std::atomic<size_t> iWarmed{0};
+		std::vector<std::thread> vecThreads;
+		vecThreads.reserve(vecHandles.size());
+		
+		for (Connection* pConn : vecHandles) {
+			vecThreads.emplace_back([pConn, &strURL, &iWarmed, &profile, strUnixSocket] {
+				CURL* pHandle = pConn->pHandle;
+				profile.bind(pHandle, pConn->state);
+				pConn->state.setUnixSocket(pHandle, strUnixSocket);
+				pConn->state.setMethod(pHandle, HttpMethod::Head, false);
+				curl_easy_setopt(pHandle, CURLOPT_URL, strURL.c_str());
+				
+				// handshakes to far hosts get the whole timeout and nothing is
+				// kept of the reply. the profile does not track either, so the
+				// first real request rebinds
+				long iTimeoutMs = static_cast<long>(profile.getSettings().timeTimeout.count());
+				curl_easy_setopt(pHandle, CURLOPT_CONNECTTIMEOUT_MS, iTimeoutMs);
+				curl_easy_setopt(pHandle, CURLOPT_WRITEFUNCTION, discardData);
+				curl_easy_setopt(pHandle, CURLOPT_HEADERFUNCTION, discardData);
+				
+				if (curl_easy_perform(pHandle) == CURLE_OK) {
+					iWarmed.fetch_add(1, std::memory_order_relaxed);
+				}
+				pConn->state.complete();
+				pConn->state.invalidate();
+			});
+		}
+		
+		for (auto& thread : vecThreads) {
+			thread.join();
+		}
+		
+		for (Connection* pConn : vecHandles) {
+			returnConnection(pConn->pHandle);
+		}
+		
+		return iWarmed.load();
+	}
+	
+	// closes connections idle for longer than timeIdleTTL. hosts that saw traffic
+	// within the ttl keep at least iMinWarmPerHost connections open
+	size_t reapIdleConnections(std::chrono::milliseconds timeIdleTTL, size_t iMinWarmPerHost) {
+		struct HostState {
+			size_t iTotal{0};
+			bool bHot{false};
+			std::vector<Connection*> vecExpired;
+		};
+		
+		std::vector<std::unique_ptr<Connection>> vecReaped;
+		{
+			std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+			
+			auto timeNow = std::chrono::high_resolution_clock::now();
+			std::unordered_map<std::string, HostState> mapHosts;
+			
+			for (const auto& pConn : vecConnections) {
+				auto& hostState = mapHosts[pConn->strHost];
+				++hostState.iTotal;
+				
+				if (pConn->bInUse || timeNow - pConn->timeLastUsed < timeIdleTTL) {
+					hostState.bHot = true;
+				} else {
+					hostState.vecExpired.push_back(pConn.get());
+				}
+			}
+			
+			std::vector<Connection*> vecToReap;
+			for (auto& [strHost, hostState] : mapHosts) {
+				size_t iReapable = hostState.vecExpired.size();
+				if (hostState.bHot) {
+					size_t iSpare = hostState.iTotal > iMinWarmPerHost ? hostState.iTotal - iMinWarmPerHost : 0;
+					iReapable = std::min(iReapable, iSpare);
+				}
+				
+				std::sort(hostState.vecExpired.begin(), hostState.vecExpired.end(), [](const Connection* a, const Connection* b) {
+					return a->timeLastUsed < b->timeLastUsed;
+				});
+				vecToReap.insert(vecToReap.end(), hostState.vecExpired.begin(), hostState.vecExpired.begin() + iReapable);
+			}
+			
+			if (vecToReap.empty()) {
+				return 0;
+			}
+			
+			std::sort(vecToReap.begin(), vecToReap.end());
+			auto itKeep = std::stable_partition(vecConnections.begin(), vecConnections.end(), [&vecToReap](const std::unique_ptr<Connection>& pConn) {
+				return !std::binary_search(vecToReap.begin(), vecToReap.end(), pConn.get());
+			});
+			
+			std::move(itKeep, vecConnections.end(), std::back_inserter(vecReaped));
+			vecConnections.erase(itKeep, vecConnections.end());
+			iTotalConnections.fetch_sub(vecReaped.size());
+		}
+		
+		// curl_easy_cleanup may block on tls shutdown, keep it outside the lock
+		return vecReaped.size();
+	}
+	
+	size_t getConnectionCount() const noexcept {
+		return iTotalConnections.load(std::memory_order_relaxed);
+	}
+	
+	size_t getIdleConnectionCount() {
+		std::lock_guard<CInstrumentedMutex> lock(mutexConnections);
+		return std::count_if(vecConnections.begin(), vecConnections.end(), [](const std::unique_ptr<Connection>& pConn) {
+			return !pConn->bInUse;
+		});
+	}
 };
 
+class CRequestCoalescer;
+class CResponseCache;
+struct CacheStats;
+struct UpstreamGroupConfig;
+struct UpstreamEndpointStats;
+class CCircuitBreaker;
+struct CircuitBreakerConfig;
+struct CircuitStats;
+class CWorkerAutoscaler;
+struct AutoscaleConfig;
+class CDnsCache;
+struct DnsCacheConfig;
+struct DnsCacheStats;
+class CWarmStartState;
+struct WarmStartStats;
+
 class CWorkerPool {
  public:
 	explicit CWorkerPool(size_t iNumWorkers = std::thread::hardware_concurrency());
+	
+	// restores tls sessions, hsts and resolved addresses from strWarmStartFile
+	// if it exists and writes them back there on shutdown. the addresses are
+	// only used once dns caching is enabled
+	CWorkerPool(size_t iNumWorkers, std::string_view strWarmStartFile);
 	~CWorkerPool();
 	
 	CWorkerPool(const CWorkerPool&) = delete;
@@ -262,15 +633,60 @@ class CWorkerPool {
 	std::future<Response> getAsync(std::string_view strURL, 
 	                               std::string_view strEndpoint,
 	                               const std::vector<std::pair<std::string, std::string>>& vecHeaders = {});
+	
+	// cancellable requests are never coalesced, cancelling one must not
+	// take down the others waiting on the same transfer
+	std::future<Response> getAsync(std::string_view strURL, 
+	                               std::string_view strEndpoint,
+	                               const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                               CCancellationToken tokenCancel);
+	std::shared_future<Response> getSharedAsync(std::string_view strURL, 
+	                                            std::string_view strEndpoint,
+	                                            const std::vector<std::pair<std::string, std::string>>& vecHeaders = {});
 	std::future<Response> postAsync(std::string_view strURL, 
 	                                std::string_view strEndpoint, 
 	                                const std::vector<std::pair<std::string, std::string>>& vecHeaders = {}, 
 	                                std::string_view strBody = "");
+	std::future<Response> postAsync(std::string_view strURL, 
+	                                std::string_view strEndpoint, 
+	                                const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                CRequestBody bodyRequest);
 	std::future<Response> requestAsync(std::string_view strMethod, 
 	                                   std::string_view strURL, 
 	                                   std::string_view strEndpoint, 
 	                                   const std::vector<std::pair<std::string, std::string>>& vecHeaders = {}, 
 	                                   std::string_view strBody = "");
+	std::future<Response> requestAsync(std::string_view strMethod, 
+	                                   std::string_view strURL, 
+	                                   std::string_view strEndpoint, 
+	                                   const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                   CRequestBody bodyRequest);
+	std::future<Response> requestAsync(std::string_view strMethod, 
+	                                   std::string_view strURL, 
+	                                   std::string_view strEndpoint, 
+	                                   const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                   CRequestBody bodyRequest, 
+	                                   CCancellationToken tokenCancel);
+	
+	std::future<Response> getUpstreamAsync(std::string_view strGroup, 
+	                                       std::string_view strEndpoint, 
+	                                       const std::vector<std::pair<std::string, std::string>>& vecHeaders = {});
+	std::future<Response> requestUpstreamAsync(std::string_view strMethod, 
+	                                           std::string_view strGroup, 
+	                                           std::string_view strEndpoint, 
+	                                           const std::vector<std::pair<std::string, std::string>>& vecHeaders = {}, 
+	                                           std::string_view strBody = "");
+	std::future<Response> requestUpstreamAsync(std::string_view strMethod, 
+	                                           std::string_view strGroup, 
+	                                           std::string_view strEndpoint, 
+	                                           const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                           CRequestBody bodyRequest);
+	std::future<Response> requestUpstreamAsync(std::string_view strMethod, 
+	                                           std::string_view strGroup, 
+	                                           std::string_view strEndpoint, 
+	                                           const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                           CRequestBody bodyRequest, 
+	                                           CCancellationToken tokenCancel);
 	
 	void getWithCallback(std::function<void(Response)> callback, 
 	                      std::string_view strURL, 
@@ -285,31 +701,158 @@ class CWorkerPool {
 	void setTimeout(std::chrono::milliseconds timeout) noexcept;
 	void setMaxRetries(size_t iMaxRetries) noexcept;
 	void setConnectionPoolSize(size_t iPoolSize) noexcept;
+	void setIdleConnectionTTL(std::chrono::milliseconds timeIdleTTL) noexcept;
+	void setMinWarmConnections(size_t iMinWarm) noexcept;
+	void setRequestCoalescing(bool bEnabled) noexcept;
+	void setCoalescingHeaders(std::vector<std::string> vecHeaderNames);
+	void setResponseDecompression(bool bEnabled) noexcept;
+	void setRequestCompression(size_t iMinBodySize) noexcept;
+	void setResponseBufferPooling(bool bEnabled) noexcept;
+	void setNativeTransport(bool bEnabled) noexcept;
+	void setCircuitBreaker(bool bEnabled) noexcept;
+	void setCircuitBreakerConfig(const CircuitBreakerConfig& config);
+	void setAutoscaling(bool bEnabled) noexcept;
+	void setDnsCaching(bool bEnabled) noexcept;
+	void setDnsCacheConfig(const DnsCacheConfig& config);
+	void setDnsOverride(std::string_view strHost, const std::vector<std::string>& vecAddresses);
+	
+	// requests to strAuthority (host[:port] as written in the url) go over
+	// this unix domain socket, "@name" selects the abstract namespace. an
+	// empty path removes the route
+	void setUnixSocket(std::string_view strAuthority, std::string_view strSocketPath);
+	void setAutoscaleConfig(const AutoscaleConfig& config);
+	void setResponseCacheSize(size_t iMaxBytes);
+	void clearResponseCache();
+	
+	// replaces any group of the same name, requests already queued keep
+	// using the old one
+	void addUpstreamGroup(std::string_view strName, const std::vector<std::string>& vecEndpointURLs);
+	void addUpstreamGroup(std::string_view strName, const std::vector<std::string>& vecEndpointURLs, const UpstreamGroupConfig& config);
+	bool removeUpstreamGroup(std::string_view strName);
+	
+	size_t prewarm(std::string_view strURL, size_t iCount);
+	
+	// takes a bare host name or a url
+	void prefetchHost(std::string_view strHost);
+	
+	// writes the warm-start snapshot now, false without a snapshot file
+	bool saveWarmStart();
 	
 	size_t getPendingRequestCount() const noexcept;
 	size_t getActiveWorkerCount() const noexcept;
+	size_t getBusyWorkerCount() const noexcept;
+	size_t getIdleWorkerCount() const noexcept;
+	size_t getOpenConnectionCount() const noexcept;
+	size_t getCoalescedRequestCount() const noexcept;
+	CacheStats getCacheStats() const;
+	BufferPoolStats getBufferPoolStats() const;
+	std::vector<UpstreamEndpointStats> getUpstreamStats(std::string_view strGroup) const;
+	std::vector<CircuitStats> getCircuitStats() const;
+	DnsCacheStats getDnsCacheStats() const;
+	WarmStartStats getWarmStartStats() const;
 	bool isRunning() const noexcept;
 	
+	// 0 turns profiling off, n samples one in every n lock acquisitions and
+	// hot-path stage passes on each thread
+	void setProfilingSampleRate(std::uint32_t iInterval) noexcept;
+	ProfilerStats getProfilerStats() const;
+	void resetProfilerStats() noexcept;
+	
 	void shutdown();
 	void waitForCompletion();
 	
  private:
-	void workerLoop(size_t iWorkerId);
-	void processRequest(Request&& request);
-	Response executeHttpRequest(const Request& request);
+	// a worker asked to stop finishes its current request and exits, the
+	// slot is joined and dropped on the next resize
+	struct WorkerSlot {
+		std::thread threadWorker;
+		std::atomic<bool> bStopRequested{false};
+		std::atomic<bool> bExited{false};
+	};
 	
-	std::vector<std::thread> vecWorkers;
+	void workerLoop(WorkerSlot* pSlot, size_t iWorkerId);
+	void resizeWorkers(size_t iTargetCount);
+	void autoscale();
+	void maintenanceLoop();
+	void processRequest(Request&& request);
+	void completeRequest(Request& request, Response&& response);
+	static HttpMethod validateRequest(std::string_view strMethod, 
+	                                  const std::string& strFullURL, 
+	                                  const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                                  size_t iBufferedBodySize);
+	bool serveFromCache(const std::string& strFullURL, Request& request);
+	Response executeHttpRequest(const Request& request, std::string_view strBaseURL, CConnectionPool& connectionPool, std::string_view strUnixSocket);
+	void rebuildHandleProfile();
+	Response executeUpstreamRequest(const Request& request);
+	Response executeGuardedRequest(const Request& request, std::string_view strBaseURL, CConnectionPool& connectionPool, std::string_view strUnixSocket);
+	std::string findUnixSocket(std::string_view strBaseURL) const;
+	std::shared_ptr<CUpstreamGroup> findUpstreamGroup(std::string_view strName) const;
+	
+	std::vector<std::unique_ptr<WorkerSlot>> vecWorkers;
+	mutable std::mutex mutexWorkers;
+	size_t iNextWorkerId{0};
+	std::atomic<size_t> iBusyWorkers{0};
+	
+	std::unique_ptr<CWorkerAutoscaler> pAutoscaler;
+	std::atomic<bool> bAutoscaling{false};
+	std::chrono::steady_clock::time_point timeLastAutoscale;
+	std::atomic<std::uint64_t> iQueueWaitMicros{0};
+	std::atomic<std::uint64_t> iQueueWaitSamples{0};
+	
+	// declared ahead of the queue and the pools whose mutexes report to it
+	std::unique_ptr<CHotPathProfiler> pProfiler;
 	CFastQueue queueRequests;
 	std::atomic<bool> bShutdownFlag{false};
 	std::atomic<size_t> iPendingRequests{0};
 	
+	// declared ahead of every connection pool, the share has to outlive their handles
+	std::unique_ptr<CWarmStartState> pWarmStart;
+	std::string strWarmStartFile;
+	std::mutex mutexWarmStart;
+	
 	std::unique_ptr<CConnectionPool> pConnectionPool;
 	
+	std::thread threadMaintenance;
+	std::mutex mutexMaintenance;
+	std::condition_variable conditionMaintenance;
+	std::atomic<std::chrono::milliseconds> timeIdleTTL{std::chrono::milliseconds(60000)};
+	std::atomic<size_t> iMinWarmConnections{1};
+	
+	std::unique_ptr<CRequestCoalescer> pCoalescer;
+	std::atomic<bool> bCoalesceRequests{false};
+	
+	std::unique_ptr<CResponseCache> pResponseCache;
+	
+	std::atomic<bool> bAcceptEncoding{true};
+	std::atomic<size_t> iCompressionThreshold{0};
+	
+	// swapped whole when the timeout or decompression setting changes
+	std::atomic<std::shared_ptr<const CHandleProfile>> pHandleProfile;
+	std::mutex mutexHandleProfile;
+	
+	std::atomic<bool> bPoolResponseBuffers{true};
+	std::vector<std::shared_ptr<CBufferPool>> vecBufferPools;
+	std::vector<std::shared_ptr<CBufferPool>> vecIdleBufferPools;
+	
+	std::atomic<bool> bNativeTransport{false};
+	
+	std::unordered_map<std::string, std::shared_ptr<CUpstreamGroup>, CStringHash, std::equal_to<>> mapUpstreamGroups;
+	mutable std::mutex mutexUpstreams;
+	
+	std::unique_ptr<CCircuitBreaker> pCircuitBreaker;
+	
+	std::unique_ptr<CDnsCache> pDnsCache;
+	
+	std::unordered_map<std::string, std::string, CStringHash, std::equal_to<>> mapUnixSockets;
+	mutable std::shared_mutex mutexUnixSockets;
+	std::atomic<bool> bUnixSocketRoutes{false};
+	std::atomic<bool> bCircuitBreaking{false};
+	
 	std::chrono::milliseconds timeTimeout{1000};
 	size_t iMaxRetries{1};
 	size_t iConnectionPoolSize{50};
 	
-	mutable std::mutex mutexStats;
+	mutable CInstrumentedMutex mutexStats;
 	std::atomic<size_t> iTotalRequests{0};
 	std::atomic<size_t> iSuccessfulRequests{0};
 	std::atomic<size_t> iFailedRequests{0};
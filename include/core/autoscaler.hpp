@@ -0,0 +1,57 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_AUTOSCALER_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_AUTOSCALER_H_
+
+#include <chrono>
+#include <mutex>
+
+struct AutoscaleConfig {
+	size_t iMinWorkers{1};
+	size_t iMaxWorkers{64};
+	
+	// grow when the backlog per worker, the share of busy workers or the
+	// average time requests spent queued crosses these. zero wait disables
+	// the latency trigger
+	double dScaleUpQueuePerWorker{2.0};
+	double dScaleUpBusyRatio{0.9};
+	std::chrono::milliseconds timeQueueWaitTarget{50};
+	
+	// shrink only after the pool has stayed below dScaleDownBusyRatio with an
+	// empty queue for timeScaleDownDelay, every step restarts that wait
+	double dScaleDownBusyRatio{0.5};
+	std::chrono::milliseconds timeScaleDownDelay{5000};
+	
+	std::chrono::milliseconds timeEvaluationInterval{250};
+};
+
+struct WorkerLoadSample {
+	size_t iWorkers{0};
+	size_t iBusyWorkers{0};
+	size_t iQueueDepth{0};
+	std::chrono::microseconds timeAverageQueueWait{0};
+};
+
+// decides the worker count, CWorkerPool feeds it samples from the
+// maintenance thread and applies the result. growth is immediate and
+// proportional, shrinking is gradual so bursts do not make the pool flap
+class CWorkerAutoscaler {
+ public:
+	CWorkerAutoscaler() = default;
+	~CWorkerAutoscaler() = default;
+	
+	CWorkerAutoscaler(const CWorkerAutoscaler&) = delete;
+	CWorkerAutoscaler& operator=(const CWorkerAutoscaler&) = delete;
+	
+	void setConfig(const AutoscaleConfig& config);
+	AutoscaleConfig getConfig() const;
+	
+	// returns the worker count to move to, sample.iWorkers means no change
+	size_t evaluate(const WorkerLoadSample& sample, std::chrono::steady_clock::time_point timeNow);
+	
+ private:
+	AutoscaleConfig config;
+	bool bCalm{false};
+	std::chrono::steady_clock::time_point timeCalmSince;
+	mutable std::mutex mutexAutoscaler;
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_AUTOSCALER_H_
@@ -0,0 +1,62 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_BUFFER_POOL_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_BUFFER_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BufferPoolStats {
+	size_t iHits{0};
+	size_t iMisses{0};
+	size_t iRecycled{0};
+	size_t iDropped{0};
+	size_t iPooledBytes{0};
+};
+
+// per-worker free lists of response body and header buffers. a Response
+// remembers the pool that filled it and hands its buffers back on release, so
+// the next transfer on that worker reuses them instead of going to malloc
+class CBufferPool {
+ public:
+	static constexpr std::array<size_t, 5> SIZE_CLASSES = {
+		4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024
+	};
+	static constexpr size_t MAX_BUFFERS_PER_CLASS = 32;
+	static constexpr size_t MAX_HEADER_LISTS = 64;
+	
+	CBufferPool() = default;
+	~CBufferPool() = default;
+	
+	CBufferPool(const CBufferPool&) = delete;
+	CBufferPool& operator=(const CBufferPool&) = delete;
+	
+	// grows strBuffer to hold at least iRequired bytes, swapping in a pooled
+	// buffer of the next size class and recycling the old one
+	void reserve(std::string& strBuffer, size_t iRequired);
+	
+	// the returned list may still hold strings from an earlier response, they
+	// are overwritten in place and the caller trims the tail when done
+	std::vector<std::pair<std::string, std::string>> acquireHeaders();
+	
+	void release(std::string&& strBuffer);
+	void release(std::vector<std::pair<std::string, std::string>>&& vecHeaders);
+	
+	BufferPoolStats getStats() const;
+	
+ private:
+	static size_t classFor(size_t iRequired) noexcept;
+	
+	std::array<std::vector<std::string>, SIZE_CLASSES.size()> arrFreeBuffers;
+	std::vector<std::vector<std::pair<std::string, std::string>>> vecFreeHeaders;
+	mutable std::mutex mutexPool;
+	
+	std::atomic<size_t> iHits{0};
+	std::atomic<size_t> iMisses{0};
+	std::atomic<size_t> iRecycled{0};
+	std::atomic<size_t> iDropped{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_BUFFER_POOL_H_
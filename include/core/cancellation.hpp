@@ -0,0 +1,45 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_CANCELLATION_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_CANCELLATION_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <curl/curl.h>
+
+// cancels every request submitted with it, wherever they are. queued requests
+// are completed when a worker dequeues them, transfers in flight are aborted
+// and their connection goes back to the pool. copies share one state, so a
+// batch of requests is cancelled with a single store
+class CCancellationToken {
+ public:
+	// an empty token that can never be cancelled and costs nothing to check
+	CCancellationToken() = default;
+	
+	static CCancellationToken create();
+	
+	void cancel() const;
+	
+	bool isCancelled() const noexcept {
+		return pState && pState->bCancelled.load(std::memory_order_acquire);
+	}
+	
+	explicit operator bool() const noexcept { return pState != nullptr; }
+	
+	// a worker running one of our transfers registers its multi handle so
+	// cancel() can interrupt the poll it is blocked in
+	void attachWaker(CURLM* pMulti) const;
+	void detachWaker(CURLM* pMulti) const;
+	
+ private:
+	struct State {
+		std::atomic<bool> bCancelled{false};
+		std::mutex mutexWakers;
+		std::vector<CURLM*> vecWakers;
+	};
+	
+	std::shared_ptr<State> pState;
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_CANCELLATION_H_
@@ -0,0 +1,103 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_CIRCUIT_BREAKER_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_CIRCUIT_BREAKER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/async_client.hpp"
+
+enum class CircuitState : std::uint8_t {
+	Closed,
+	Open,
+	HalfOpen
+};
+
+struct CircuitBreakerConfig {
+	// a closed circuit trips on this many failures in a row, or when the
+	// failure rate over the window reaches dFailureRate with enough samples
+	size_t iConsecutiveFailures{5};
+	double dFailureRate{0.5};
+	size_t iMinimumRequests{20};
+	std::chrono::milliseconds timeWindow{10000};
+	
+	// an open circuit rejects everything for timeOpen, then lets up to
+	// iHalfOpenProbes requests through and closes once all of them succeed
+	std::chrono::milliseconds timeOpen{5000};
+	size_t iHalfOpenProbes{1};
+};
+
+struct CircuitStats {
+	std::string strHost;
+	CircuitState eState{CircuitState::Closed};
+	size_t iWindowRequests{0};
+	size_t iWindowFailures{0};
+	size_t iRejected{0};
+	size_t iTrips{0};
+	size_t iRecoveries{0};
+	std::chrono::steady_clock::time_point timeLastChange;
+};
+
+// per-host closed/open/half-open breaker. transport failures and gateway
+// errors count against a host, everything else counts as success
+class CCircuitBreaker {
+ public:
+	enum class Admission {
+		Allowed,
+		Probe,
+		Rejected
+	};
+	
+	CCircuitBreaker() = default;
+	~CCircuitBreaker() = default;
+	
+	CCircuitBreaker(const CCircuitBreaker&) = delete;
+	CCircuitBreaker& operator=(const CCircuitBreaker&) = delete;
+	
+	void setConfig(const CircuitBreakerConfig& config);
+	
+	// admissions other than Rejected must be followed by record()
+	Admission tryAcquire(std::string_view strHost);
+	void record(std::string_view strHost, Admission eAdmission, bool bFailure);
+	
+	// check used before queueing, counts the rejection but never takes a
+	// probe slot
+	bool rejectIfOpen(std::string_view strHost);
+	
+	std::vector<CircuitStats> getStats() const;
+	
+	static bool isFailure(const Response& response) noexcept;
+	
+ private:
+	struct Circuit {
+		mutable std::mutex mutexCircuit;
+		CircuitState eState{CircuitState::Closed};
+		size_t iConsecutiveFailures{0};
+		size_t iWindowRequests{0};
+		size_t iWindowFailures{0};
+		size_t iProbesInFlight{0};
+		size_t iProbeSuccesses{0};
+		size_t iRejected{0};
+		size_t iTrips{0};
+		size_t iRecoveries{0};
+		std::chrono::steady_clock::time_point timeWindowStart;
+		std::chrono::steady_clock::time_point timeLastChange;
+	};
+	
+	// circuits are never erased, so a pointer stays valid after the map lock
+	// is released
+	Circuit& findCircuit(std::string_view strHost, CircuitBreakerConfig& configOut);
+	Circuit* findExisting(std::string_view strHost, CircuitBreakerConfig& configOut);
+	static void trip(Circuit& circuit, std::chrono::steady_clock::time_point timeNow);
+	
+	std::unordered_map<std::string, std::unique_ptr<Circuit>, CStringHash, std::equal_to<>> mapCircuits;
+	CircuitBreakerConfig config;
+	mutable std::mutex mutexCircuits;
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_CIRCUIT_BREAKER_H_
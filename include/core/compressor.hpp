@@ -0,0 +1,31 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_COMPRESSOR_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_COMPRESSOR_H_
+
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+// reusable gzip context for request bodies. one instance lives per worker
+// thread so the deflate state and output buffer are allocated only once
+class CGzipCompressor {
+ public:
+	explicit CGzipCompressor(int iLevel = Z_DEFAULT_COMPRESSION);
+	~CGzipCompressor();
+	
+	CGzipCompressor(const CGzipCompressor&) = delete;
+	CGzipCompressor& operator=(const CGzipCompressor&) = delete;
+	
+	// the returned view points into the internal buffer and stays valid until
+	// the next call. returns an empty view if compression failed
+	std::string_view compress(std::string_view strInput);
+	
+	bool isValid() const noexcept { return bInitialized; }
+	
+ private:
+	z_stream streamDeflate{};
+	std::string strOutput;
+	bool bInitialized{false};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_COMPRESSOR_H_
@@ -0,0 +1,139 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_DNS_CACHE_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_DNS_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "core/intern_pool.hpp"
+
+struct DnsCacheConfig {
+	// getaddrinfo reports no ttl, entries live this long after a lookup
+	std::chrono::milliseconds timeTTL{60000};
+	
+	// entries that were used since their last lookup are re-resolved in the
+	// background once this share of the ttl has passed
+	double dRefreshAhead{0.75};
+	
+	// failed lookups are remembered briefly so a dead name is not hammered
+	std::chrono::milliseconds timeNegativeTTL{5000};
+	
+	size_t iResolverThreads{2};
+};
+
+struct DnsCacheStats {
+	size_t iHits{0};
+	size_t iMisses{0};
+	size_t iLookups{0};
+	size_t iRefreshes{0};
+	size_t iFailures{0};
+	size_t iEntries{0};
+};
+
+// a resolved host as written to a warm-start snapshot. the expiry is wall
+// clock time so it stays meaningful across a restart
+struct DnsSnapshotEntry {
+	std::string strHost;
+	std::vector<std::string> vecAddresses;
+	std::chrono::system_clock::time_point timeExpires;
+};
+
+// client-wide resolver cache. lookups run on a few background threads, the
+// request path only ever reads what is already there and hands it to curl
+// via CURLOPT_RESOLVE, so a slow resolver never stalls a worker
+class CDnsCache {
+ public:
+	CDnsCache() = default;
+	~CDnsCache();
+	
+	CDnsCache(const CDnsCache&) = delete;
+	CDnsCache& operator=(const CDnsCache&) = delete;
+	
+	void setConfig(const DnsCacheConfig& config);
+	
+	// disabled, only overrides are served and nothing is resolved
+	void setEnabled(bool bEnabled) noexcept { this->bEnabled.store(bEnabled, std::memory_order_relaxed); }
+	bool isActive() const noexcept {
+		return bEnabled.load(std::memory_order_relaxed) || iOverrides.load(std::memory_order_relaxed) > 0;
+	}
+	
+	// queues a lookup unless the host is cached, pending or an ip literal
+	void prefetch(std::string_view strHost);
+	
+	// fills vecAddresses on a hit. a miss queues a lookup and returns false
+	bool lookup(std::string_view strHost, std::vector<std::string>& vecAddresses);
+	
+	// "host:port:addr1,addr2" for CURLOPT_RESOLVE, empty on a miss
+	std::string formatResolveEntry(std::string_view strHost, std::uint16_t iPort);
+	
+	// pins a host to fixed addresses that are never refreshed, an empty list
+	// removes the pin
+	void setOverride(std::string_view strHost, const std::vector<std::string>& vecAddresses);
+	
+	// called periodically: queues refreshes for entries in use and drops the
+	// ones nobody asked for within their ttl
+	void refreshExpiring();
+	
+	// resolved entries only, overrides and failures are not carried over
+	std::vector<DnsSnapshotEntry> exportEntries() const;
+	
+	// restores entries that have not expired yet and are not already cached,
+	// returns how many were taken
+	size_t importEntries(const std::vector<DnsSnapshotEntry>& vecSnapshot);
+	
+	void clear();
+	DnsCacheStats getStats() const;
+	
+	static bool isAddressLiteral(std::string_view strHost) noexcept;
+	
+ private:
+	using Clock = std::chrono::steady_clock;
+	
+	struct Entry {
+		std::vector<std::string> vecAddresses;
+		std::string strJoined;
+		Clock::time_point timeResolved;
+		Clock::time_point timeExpires;
+		std::atomic<std::int64_t> iLastUsed{0};
+		bool bStatic{false};
+		bool bPending{false};
+		bool bFailed{false};
+	};
+	
+	bool find(std::string_view strHost, std::string* pJoined, std::vector<std::string>* pAddresses);
+	void enqueue(std::string_view strHost, bool bRefresh);
+	void pushLookup(std::string strHost, bool bRefresh);
+	void resolverLoop();
+	void resolve(const std::string& strHost, bool bRefresh);
+	static std::int64_t ticks(Clock::time_point timePoint) noexcept;
+	
+	std::unordered_map<std::string, Entry, CStringHash, std::equal_to<>> mapEntries;
+	mutable std::shared_mutex mutexEntries;
+	DnsCacheConfig config;
+	
+	std::deque<std::pair<std::string, bool>> queueLookups;
+	std::vector<std::thread> vecResolvers;
+	std::mutex mutexLookups;
+	std::condition_variable conditionLookups;
+	bool bStopping{false};
+	
+	std::atomic<bool> bEnabled{false};
+	std::atomic<size_t> iOverrides{0};
+	
+	std::atomic<size_t> iHits{0};
+	std::atomic<size_t> iMisses{0};
+	std::atomic<size_t> iLookups{0};
+	std::atomic<size_t> iRefreshes{0};
+	std::atomic<size_t> iFailures{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_DNS_CACHE_H_
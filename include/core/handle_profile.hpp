@@ -0,0 +1,98 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_HANDLE_PROFILE_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_HANDLE_PROFILE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <curl/curl.h>
+
+#include "utils/utils.hpp"
+
+// what the requests so far left set on one handle, so the next request only
+// touches the options that differ. lives as long as the handle it describes
+class CHandleState {
+ public:
+	// method and body mode, switched only when they differ from the last request
+	void setMethod(CURL* pHandle, HttpMethod eMethod, bool bStreamBody);
+	
+	// the body of this request for the method set above, body-less methods ignore it
+	void setBody(CURL* pHandle, std::string_view strBody, void* pReadData, curl_off_t iStreamSize);
+	
+	// the lists have to stay alive until the transfer finished, the next
+	// request on the handle replaces or clears them
+	void setHeaders(CURL* pHandle, curl_slist* pHeaders);
+	void setResolve(CURL* pHandle, curl_slist* pResolve);
+	
+	// "@name" is an abstract socket. libcurl 7.88 does not reuse connections
+	// to those, each request opens a new one, paths are reused as usual
+	void setUnixSocket(CURL* pHandle, std::string_view strUnixSocket);
+	
+	// the transfer finished, everything it set is tracked above
+	void complete() noexcept { bBusy = false; }
+	
+	// someone changed options behind our back, the next bind resets the handle
+	void invalidate() noexcept { iProfile = 0; }
+	
+ private:
+	friend class CHandleProfile;
+	
+	enum class Shape : std::uint8_t {
+		Get,
+		Head,
+		Delete,
+		Options,
+		PostBuffered,
+		PostStreamed,
+		PutBuffered,
+		PutStreamed
+	};
+	
+	static Shape shapeOf(HttpMethod eMethod, bool bStreamBody) noexcept;
+	
+	std::uint64_t iProfile{0};
+	Shape eShape{Shape::Get};
+	bool bHeaders{false};
+	bool bResolve{false};
+	bool bBusy{false};
+	std::string strUnixSocket;
+};
+
+// the options every request on a handle shares. a handle is configured from
+// a profile once and only reset when it moves to another profile, requests
+// then set what differs through CHandleState. profiles are immutable, the
+// worker pool swaps in a new one when one of the settings changes
+class CHandleProfile {
+ public:
+	struct Settings {
+		std::chrono::milliseconds timeTimeout{1000};
+		std::chrono::milliseconds timeConnectTimeout{500};
+		bool bAcceptEncoding{true};
+		curl_write_callback fnWrite{nullptr};
+		curl_write_callback fnHeader{nullptr};
+		curl_read_callback fnRead{nullptr};
+	};
+	
+	static constexpr const char* USER_AGENT = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36";
+	
+	explicit CHandleProfile(const Settings& settings);
+	
+	std::uint64_t getId() const noexcept { return iId; }
+	const Settings& getSettings() const noexcept { return settings; }
+	
+	// resets and configures pHandle unless it is on this profile already and
+	// its last request completed. returns whether it was reset. the handle
+	// counts as busy until CHandleState::complete, a request that never gets
+	// there leaves options we do not track and costs a reset on the next bind
+	bool bind(CURL* pHandle, CHandleState& state) const;
+	
+ private:
+	static std::atomic<std::uint64_t> iNextId;
+	
+	std::uint64_t iId;
+	Settings settings;
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_HANDLE_PROFILE_H_
@@ -0,0 +1,75 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_HTTP1_CODEC_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_HTTP1_CODEC_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "core/async_client.hpp"
+
+class CHttp1Serializer {
+ public:
+	// writes request line and headers into strHead, the body is sent from its
+	// own buffer afterwards so it is never copied
+	static void writeRequestHead(std::string& strHead, 
+	                             HttpMethod eMethod, 
+	                             std::string_view strTarget, 
+	                             std::string_view strHostHeader, 
+	                             const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                             size_t iBodySize);
+};
+
+// incremental HTTP/1.1 response parser. bytes can be fed in arbitrary pieces,
+// status, headers and the decoded body are written straight into a Response
+class CHttp1ResponseParser {
+ public:
+	enum class State {
+		StatusLine,
+		Headers,
+		Body,
+		ChunkSize,
+		ChunkData,
+		ChunkDataEnd,
+		Trailers,
+		UntilClose,
+		Done,
+		Error
+	};
+	
+	static constexpr size_t MAX_LINE_LENGTH = 16 * 1024;
+	
+	void reset(Response* pResponse, CBufferPool* pBufferPool, bool bNoBody) noexcept;
+	
+	// returns the number of bytes consumed, anything past the end of the
+	// message is left unconsumed
+	size_t feed(const char* pData, size_t iLength);
+	
+	// the peer closed the connection, which ends a body without framing
+	void finishOnClose() noexcept;
+	
+	bool isDone() const noexcept { return eState == State::Done; }
+	bool isError() const noexcept { return eState == State::Error; }
+	bool hasStarted() const noexcept { return bStarted; }
+	bool isKeepAlive() const noexcept { return bKeepAlive && eState == State::Done; }
+	
+ private:
+	void onLine(std::string_view strLine);
+	void onHeadersComplete();
+	void appendBody(const char* pData, size_t iLength);
+	
+	Response* pResponse{nullptr};
+	CBufferPool* pBufferPool{nullptr};
+	State eState{State::StatusLine};
+	std::string strLine;
+	
+	std::uint64_t iRemaining{0};
+	std::int64_t iContentLength{-1};
+	bool bChunked{false};
+	bool bKeepAlive{true};
+	bool bNoBody{false};
+	bool bStarted{false};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_HTTP1_CODEC_H_
@@ -0,0 +1,92 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_INTERN_POOL_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_INTERN_POOL_H_
+
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// hashes std::string and std::string_view alike so lookups need no temporary
+struct CStringHash {
+	using is_transparent = void;
+	size_t operator()(std::string_view strValue) const noexcept { return std::hash<std::string_view>{}(strValue); }
+};
+
+// deduplicates immutable values so that every request referring to the same
+// base url or header set holds a refcount instead of its own copy. values no
+// request references any more are dropped on the next purge
+template<typename ValueType, typename HashType = std::hash<ValueType>>
+class CInternPool {
+ private:
+	using Pointer = std::shared_ptr<const ValueType>;
+	
+	struct Hash {
+		using is_transparent = void;
+		size_t operator()(const Pointer& pValue) const { return HashType{}(*pValue); }
+		template<typename KeyType>
+		size_t operator()(const KeyType& key) const { return HashType{}(key); }
+	};
+	
+	struct Equal {
+		using is_transparent = void;
+		bool operator()(const Pointer& a, const Pointer& b) const { return *a == *b; }
+		template<typename KeyType>
+		bool operator()(const KeyType& a, const Pointer& b) const { return *b == a; }
+		template<typename KeyType>
+		bool operator()(const Pointer& a, const KeyType& b) const { return *a == b; }
+	};
+	
+	static constexpr size_t MIN_PURGE_THRESHOLD = 64;
+	
+	std::unordered_set<Pointer, Hash, Equal> setValues;
+	std::mutex mutexValues;
+	size_t iPurgeThreshold{MIN_PURGE_THRESHOLD};
+	
+	void purgeLocked() {
+		for (auto it = setValues.begin(); it != setValues.end();) {
+			if (it->use_count() == 1) {
+				it = setValues.erase(it);
+			} else {
+				++it;
+			}
+		}
+		iPurgeThreshold = std::max(MIN_PURGE_THRESHOLD, setValues.size() * 2);
+	}
+	
+ public:
+	CInternPool() = default;
+	~CInternPool() = default;
+	
+	CInternPool(const CInternPool&) = delete;
+	CInternPool& operator=(const CInternPool&) = delete;
+	
+	template<typename KeyType>
+	Pointer intern(KeyType&& key) {
+		std::lock_guard<std::mutex> lock(mutexValues);
+		
+		auto it = setValues.find(key);
+		if (it != setValues.end()) {
+			return *it;
+		}
+		
+		if (setValues.size() >= iPurgeThreshold) {
+			purgeLocked();
+		}
+		
+		Pointer pValue = std::make_shared<const ValueType>(std::forward<KeyType>(key));
+		setValues.insert(pValue);
+		return pValue;
+	}
+	
+	size_t size() {
+		std::lock_guard<std::mutex> lock(mutexValues);
+		return setValues.size();
+	}
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_INTERN_POOL_H_
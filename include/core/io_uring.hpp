@@ -0,0 +1,54 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_IO_URING_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_IO_URING_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+// minimal io_uring ring driven through the raw syscalls, so no liburing is
+// needed. one ring belongs to one thread, nothing here is synchronised
+class CIoUring {
+ public:
+	explicit CIoUring(unsigned int iEntries = 16);
+	~CIoUring();
+	
+	CIoUring(const CIoUring&) = delete;
+	CIoUring& operator=(const CIoUring&) = delete;
+	
+	// false when the kernel refused the ring (old kernel, seccomp, sysctl)
+	bool isAvailable() const noexcept { return iRingFd >= 0; }
+	
+	// returns a zeroed sqe that is published by the next submitAndWait, or
+	// nullptr when the submission queue is full
+	io_uring_sqe* prepare(std::uint8_t iOpcode, int iFd, std::uint64_t iUserData) noexcept;
+	
+	// submits everything prepared and blocks for iWaitCount completions
+	int submitAndWait(unsigned int iWaitCount) noexcept;
+	
+	bool popCompletion(io_uring_cqe& cqeResult) noexcept;
+	
+ private:
+	int iRingFd{-1};
+	unsigned int iPending{0};
+	
+	void* pSqRing{nullptr};
+	void* pCqRing{nullptr};
+	size_t iSqRingSize{0};
+	size_t iCqRingSize{0};
+	io_uring_sqe* pSqes{nullptr};
+	size_t iSqesSize{0};
+	
+	unsigned int* pSqHead{nullptr};
+	unsigned int* pSqTail{nullptr};
+	unsigned int* pSqArray{nullptr};
+	unsigned int iSqMask{0};
+	unsigned int iSqEntries{0};
+	
+	unsigned int* pCqHead{nullptr};
+	unsigned int* pCqTail{nullptr};
+	io_uring_cqe* pCqes{nullptr};
+	unsigned int iCqMask{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_IO_URING_H_
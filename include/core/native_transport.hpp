@@ -0,0 +1,86 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_NATIVE_TRANSPORT_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_NATIVE_TRANSPORT_H_
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "core/async_client.hpp"
+#include "core/http1_codec.hpp"
+#include "core/intern_pool.hpp"
+#include "core/io_uring.hpp"
+
+class CDnsCache;
+struct addrinfo;
+
+// plaintext HTTP/1.1 over kept-alive sockets, bypassing libcurl. one instance
+// lives on each worker thread, sockets and the ring are never shared. send and
+// receive go through io_uring, or through poll() where the kernel has no ring
+class CNativeHttpTransport {
+ public:
+	enum class Result {
+		Completed,
+		Fallback
+	};
+	
+	static constexpr size_t MAX_IDLE_SOCKETS_PER_HOST = 16;
+	static constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+	static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{500};
+	
+	CNativeHttpTransport();
+	~CNativeHttpTransport();
+	
+	CNativeHttpTransport(const CNativeHttpTransport&) = delete;
+	CNativeHttpTransport& operator=(const CNativeHttpTransport&) = delete;
+	
+	static bool supports(std::string_view strFullURL) noexcept;
+	
+	// Fallback leaves the response empty and means libcurl has to run the
+	// request: urls we do not handle, chunked uploads and redirects of
+	// idempotent requests, which curl follows. new connections try the
+	// addresses pResolver has cached before resolving the host themselves
+	Result perform(const Request& request, 
+	               std::string_view strFullURL, 
+	               Response& response, 
+	               CBufferPool* pBufferPool, 
+	               std::chrono::milliseconds timeTimeout, 
+	               CDnsCache* pResolver = nullptr);
+	
+	bool isUsingIoUring() const noexcept { return ringIo.isAvailable(); }
+	size_t getIdleSocketCount() const noexcept;
+	
+ private:
+	using Deadline = std::chrono::steady_clock::time_point;
+	
+	struct Target {
+		std::string_view strAuthority;
+		std::string strHost;
+		std::string strPort;
+		std::string_view strPath;
+	};
+	
+	static bool parseTarget(std::string_view strFullURL, Target& target);
+	
+	int acquireSocket(const Target& target, Deadline timeDeadline, CDnsCache* pResolver, bool& bReused);
+	void releaseSocket(std::string_view strAuthority, int iSocket);
+	static int connectSocket(const Target& target, Deadline timeDeadline, CDnsCache* pResolver);
+	static int connectAny(addrinfo* pAddresses, Deadline timeDeadline);
+	
+	// 0 once the parser is done, otherwise a negative errno. bReusable tells
+	// whether the socket can go back to the idle list afterwards
+	int exchange(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable);
+	int exchangeRing(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable);
+	int exchangePoll(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable);
+	
+	CIoUring ringIo;
+	std::unordered_map<std::string, std::vector<int>, CStringHash, std::equal_to<>> mapIdleSockets;
+	std::string strRequestHead;
+	std::vector<char> vecReceiveBuffer;
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_NATIVE_TRANSPORT_H_
@@ -0,0 +1,200 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_PROFILER_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_PROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class ProfileStage : std::uint8_t {
+	Enqueue,
+	Dequeue,
+	Checkout,
+	Transfer,
+	Completion,
+	Count
+};
+
+struct LockStats {
+	std::string strName;
+	std::uint64_t iAcquisitions{0};
+	std::uint64_t iContended{0};
+	std::chrono::nanoseconds timeWaited{0};
+	std::chrono::nanoseconds timeMaxWait{0};
+};
+
+struct StageStats {
+	std::string strName;
+	std::uint64_t iSamples{0};
+	std::uint64_t iTotalCycles{0};
+	std::chrono::nanoseconds timeMean{0};
+	std::chrono::nanoseconds timeMax{0};
+};
+
+// every count is of sampled events only, multiplying by iSampleInterval
+// estimates the real totals
+struct ProfilerStats {
+	std::uint32_t iSampleInterval{0};
+	double dCyclesPerNanosecond{0.0};
+	std::vector<LockStats> vecLocks;
+	std::vector<StageStats> vecStages;
+};
+
+// sampling switch and per-stage cycle counters for one worker pool. with the
+// interval at 0 a hook costs a relaxed load and a branch, otherwise every
+// iInterval-th event on a thread is timed with the cycle counter
+class CHotPathProfiler {
+ public:
+	CHotPathProfiler();
+	
+	CHotPathProfiler(const CHotPathProfiler&) = delete;
+	CHotPathProfiler& operator=(const CHotPathProfiler&) = delete;
+	
+	static std::uint64_t readCycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+	
+	void setSampleInterval(std::uint32_t iInterval) noexcept {
+		iSampleInterval.store(iInterval, std::memory_order_relaxed);
+	}
+	
+	std::uint32_t getSampleInterval() const noexcept {
+		return iSampleInterval.load(std::memory_order_relaxed);
+	}
+	
+	bool shouldSample() const noexcept {
+		std::uint32_t iInterval = iSampleInterval.load(std::memory_order_relaxed);
+		if (iInterval == 0) {
+			return false;
+		}
+		
+		// one countdown per thread shared by every profiler, the rate only
+		// has to hold on average
+		thread_local std::uint32_t iCountdown = 0;
+		if (iCountdown == 0 || iCountdown > iInterval) {
+			iCountdown = iInterval;
+		}
+		return --iCountdown == 0;
+	}
+	
+	void record(ProfileStage eStage, std::uint64_t iCycles) noexcept;
+	
+	// measured against the steady clock over the profiler's lifetime, the
+	// first call within 10ms of construction waits for the window to fill
+	double getCyclesPerNanosecond() const;
+	std::chrono::nanoseconds toNanoseconds(std::uint64_t iCycles) const;
+	
+	std::vector<StageStats> getStageStats() const;
+	void reset() noexcept;
+	
+	static const char* getStageName(ProfileStage eStage) noexcept;
+	
+ private:
+	struct alignas(64) StageCounters {
+		std::atomic<std::uint64_t> iSamples{0};
+		std::atomic<std::uint64_t> iCycles{0};
+		std::atomic<std::uint64_t> iMaxCycles{0};
+	};
+	
+	std::array<StageCounters, static_cast<size_t>(ProfileStage::Count)> arrStages;
+	std::atomic<std::uint32_t> iSampleInterval{0};
+	
+	std::uint64_t iCalibrationCycles;
+	std::chrono::steady_clock::time_point timeCalibration;
+};
+
+// times one pass through a stage when the profiler picks it, a null
+// profiler times nothing
+class CStageTimer {
+ public:
+	CStageTimer(CHotPathProfiler* pProfiler, ProfileStage eStage) noexcept
+		: pProfiler(pProfiler), eStage(eStage), iStart(pProfiler && pProfiler->shouldSample() ? CHotPathProfiler::readCycles() : 0) {}
+	
+	~CStageTimer() {
+		if (iStart != 0) {
+			pProfiler->record(eStage, CHotPathProfiler::readCycles() - iStart);
+		}
+	}
+	
+	CStageTimer(const CStageTimer&) = delete;
+	CStageTimer& operator=(const CStageTimer&) = delete;
+	
+ private:
+	CHotPathProfiler* pProfiler;
+	ProfileStage eStage;
+	std::uint64_t iStart;
+};
+
+// std::mutex that reports to a profiler once attached. a sampled acquisition
+// tries the lock first, a failure counts as contended and the wait is timed.
+// unsampled ones go straight to the inner mutex
+class CInstrumentedMutex {
+ public:
+	CInstrumentedMutex() = default;
+	
+	CInstrumentedMutex(const CInstrumentedMutex&) = delete;
+	CInstrumentedMutex& operator=(const CInstrumentedMutex&) = delete;
+	
+	// not synchronised, attach before other threads use the mutex
+	void attach(const CHotPathProfiler* pProfiler) noexcept {
+		this->pProfiler = pProfiler;
+	}
+	
+	void lock() {
+		if (pProfiler == nullptr || !pProfiler->shouldSample()) {
+			mutexInner.lock();
+			return;
+		}
+		
+		if (!mutexInner.try_lock()) {
+			std::uint64_t iStart = CHotPathProfiler::readCycles();
+			mutexInner.lock();
+			std::uint64_t iWaited = CHotPathProfiler::readCycles() - iStart;
+			
+			// counters are written under the lock, no compare loop needed for the max
+			iContended.fetch_add(1, std::memory_order_relaxed);
+			iWaitCycles.fetch_add(iWaited, std::memory_order_relaxed);
+			if (iWaited > iMaxWaitCycles.load(std::memory_order_relaxed)) {
+				iMaxWaitCycles.store(iWaited, std::memory_order_relaxed);
+			}
+		}
+		iAcquisitions.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	bool try_lock() {
+		return mutexInner.try_lock();
+	}
+	
+	void unlock() {
+		mutexInner.unlock();
+	}
+	
+	// for waiting on a std::condition_variable after an instrumented lock()
+	std::mutex& native() noexcept {
+		return mutexInner;
+	}
+	
+	LockStats getStats(std::string strName) const;
+	void resetStats() noexcept;
+	
+ private:
+	std::mutex mutexInner;
+	const CHotPathProfiler* pProfiler{nullptr};
+	std::atomic<std::uint64_t> iAcquisitions{0};
+	std::atomic<std::uint64_t> iContended{0};
+	std::atomic<std::uint64_t> iWaitCycles{0};
+	std::atomic<std::uint64_t> iMaxWaitCycles{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_PROFILER_H_
@@ -0,0 +1,43 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_BODY_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_BODY_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// request payload that is either owned, shared between requests, borrowed from
+// the caller or backed by a memory-mapped file. copying a body only bumps the
+// refcount of whatever keeps the bytes alive
+class CRequestBody {
+ public:
+	CRequestBody() = default;
+	
+	static CRequestBody owned(std::string strBody);
+	static CRequestBody copy(std::string_view strBody);
+	
+	// immutable buffer shared by every request that posts it
+	static CRequestBody shared(std::shared_ptr<const std::string> pBody);
+	
+	// no copy and no ownership, the caller keeps the bytes alive and unchanged
+	// until the response future of every request using them is ready
+	static CRequestBody borrowed(std::string_view strBody) noexcept;
+	
+	// maps strPath read-only and streams it through CURLOPT_READFUNCTION. with
+	// bChunked the length is not announced and chunked transfer encoding is used
+	static CRequestBody mappedFile(const std::string& strPath, bool bChunked = false);
+	
+	std::string_view view() const noexcept { return strView; }
+	size_t size() const noexcept { return strView.size(); }
+	bool empty() const noexcept { return strView.empty(); }
+	
+	bool isStreamed() const noexcept { return bStreamed; }
+	bool isChunked() const noexcept { return bChunked; }
+	
+ private:
+	std::shared_ptr<const void> pOwner;
+	std::string_view strView;
+	bool bStreamed{false};
+	bool bChunked{false};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_BODY_H_
@@ -0,0 +1,62 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_COALESCER_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_COALESCER_H_
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/async_client.hpp"
+
+// single-flight layer: identical idempotent requests that arrive while one is
+// already in flight attach to it instead of going through the queue again
+class CRequestCoalescer {
+ public:
+	CRequestCoalescer() = default;
+	~CRequestCoalescer() = default;
+	
+	CRequestCoalescer(const CRequestCoalescer&) = delete;
+	CRequestCoalescer& operator=(const CRequestCoalescer&) = delete;
+	
+	// restricts the headers that take part in the key, empty means all of them
+	void setKeyHeaders(std::vector<std::string> vecHeaderNames);
+	
+	std::string buildKey(std::string_view strMethod, 
+	                     std::string_view strFullURL, 
+	                     const std::vector<std::pair<std::string, std::string>>& vecHeaders) const;
+	
+	// both return true when the caller became the leader and has to submit request
+	bool join(const std::string& strKey, Request& request, std::future<Response>& futureResult);
+	bool joinShared(const std::string& strKey, Request& request, std::shared_future<Response>& futureResult);
+	
+	size_t getCoalescedCount() const noexcept { return iCoalescedRequests.load(std::memory_order_relaxed); }
+	size_t getInFlightCount() const;
+	
+ private:
+	struct InFlight {
+		// set when the leader itself asked for a shared result, otherwise created
+		// lazily for the first shared follower
+		std::shared_future<Response> futureShared;
+		std::promise<Response> promiseShared;
+		bool bOwnsSharedPromise{false};
+		
+		std::vector<std::promise<Response>> vecWaiters;
+	};
+	
+	InFlight& lead(const std::string& strKey, Request& request);
+	void complete(const std::string& strKey, const Response& response);
+	
+	std::unordered_map<std::string, InFlight> mapInFlight;
+	mutable std::mutex mutexInFlight;
+	
+	std::vector<std::string> vecKeyHeaders;
+	mutable std::mutex mutexKeyHeaders;
+	
+	std::atomic<size_t> iCoalescedRequests{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_REQUEST_COALESCER_H_
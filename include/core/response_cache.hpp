@@ -0,0 +1,103 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_RESPONSE_CACHE_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_RESPONSE_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/async_client.hpp"
+
+struct CacheStats {
+	size_t iHits{0};
+	size_t iMisses{0};
+	size_t iRevalidations{0};
+	size_t iStores{0};
+	size_t iEvictions{0};
+	size_t iEntries{0};
+	size_t iBytes{0};
+};
+
+// private in-memory cache for GET responses, sharded lru bounded by bytes.
+// freshness follows Cache-Control / Expires, stale entries carrying an ETag or
+// Last-Modified are revalidated and a 304 turns into a cached hit
+class CResponseCache {
+ public:
+	enum class LookupResult {
+		Miss,
+		Fresh,
+		Stale
+	};
+	
+	explicit CResponseCache(size_t iMaxBytes = 0);
+	~CResponseCache() = default;
+	
+	CResponseCache(const CResponseCache&) = delete;
+	CResponseCache& operator=(const CResponseCache&) = delete;
+	
+	void setMaxBytes(size_t iMaxBytes);
+	bool isEnabled() const noexcept { return iMaxBytes.load(std::memory_order_relaxed) > 0; }
+	
+	static bool isCacheableRequest(const std::vector<std::pair<std::string, std::string>>& vecHeaders) noexcept;
+	
+	// pCached is set for Fresh and Stale results
+	LookupResult lookup(const std::string& strKey, 
+	                    const std::vector<std::pair<std::string, std::string>>& vecHeaders, 
+	                    std::shared_ptr<const Response>& pCached);
+	
+	static void addValidators(const Response& responseCached, std::vector<std::pair<std::string, std::string>>& vecHeaders);
+	
+	// installs the completion hook that stores the response, or folds a 304
+	// into pStale when the request was a revalidation
+	void attach(const std::string& strKey, Request& request, std::shared_ptr<const Response> pStale = nullptr);
+	
+	void clear();
+	CacheStats getStats() const;
+	
+ private:
+	static constexpr size_t SHARD_COUNT = 16;
+	static constexpr size_t ENTRY_OVERHEAD = 256;
+	
+	struct Entry {
+		std::string strKey;
+		std::shared_ptr<const Response> pResponse;
+		std::vector<std::pair<std::string, std::string>> vecVary;
+		std::chrono::steady_clock::time_point timeExpires;
+		size_t iBytes{0};
+	};
+	
+	struct Shard {
+		mutable std::mutex mutexShard;
+		std::list<Entry> listEntries;
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> mapEntries;
+		size_t iBytes{0};
+	};
+	
+	Shard& getShard(const std::string& strKey) noexcept;
+	void store(const std::string& strKey, 
+	           const std::vector<std::pair<std::string, std::string>>& vecRequestHeaders, 
+	           const Response& response);
+	void revalidated(const std::string& strKey, 
+	                 const std::vector<std::pair<std::string, std::string>>& vecRequestHeaders, 
+	                 const Response& responseStale, 
+	                 Response& response);
+	void evictLocked(Shard& shard, std::list<Entry>::iterator itEntry);
+	
+	std::array<Shard, SHARD_COUNT> arrShards;
+	std::atomic<size_t> iMaxBytes{0};
+	
+	std::atomic<size_t> iHits{0};
+	std::atomic<size_t> iMisses{0};
+	std::atomic<size_t> iRevalidations{0};
+	std::atomic<size_t> iStores{0};
+	std::atomic<size_t> iEvictions{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_RESPONSE_CACHE_H_
@@ -0,0 +1,118 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_UPSTREAM_GROUP_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_UPSTREAM_GROUP_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/async_client.hpp"
+
+enum class BalancingPolicy : std::uint8_t {
+	RoundRobin,
+	LeastOutstanding,
+	PeakEwma,
+	PowerOfTwoChoices
+};
+
+struct UpstreamGroupConfig {
+	BalancingPolicy ePolicy{BalancingPolicy::PeakEwma};
+	
+	// passive health checking: this many failures in a row take an endpoint
+	// out of rotation for timeEjection
+	size_t iEjectAfterFailures{5};
+	std::chrono::milliseconds timeEjection{10000};
+	
+	// time constant of the latency average, older samples fade out over it
+	std::chrono::milliseconds timeEwmaDecay{10000};
+};
+
+struct UpstreamEndpointStats {
+	std::string strURL;
+	size_t iOutstanding{0};
+	size_t iRequests{0};
+	size_t iFailures{0};
+	size_t iEjections{0};
+	double dLatencyEwmaMs{0.0};
+	bool bEjected{false};
+};
+
+// one replica of an upstream group with its own curl handle pool. an
+// endpoint given as "unix:<path>" or "unix:@<name>" is reached over that
+// unix domain socket and addressed as http://localhost
+class CUpstreamEndpoint {
+ public:
+	static constexpr std::string_view UNIX_SOCKET_PREFIX = "unix:";
+	
+	explicit CUpstreamEndpoint(std::string strURL);
+	
+	CUpstreamEndpoint(const CUpstreamEndpoint&) = delete;
+	CUpstreamEndpoint& operator=(const CUpstreamEndpoint&) = delete;
+	
+	const std::string& getURL() const noexcept { return strURL; }
+	const std::string& getUnixSocket() const noexcept { return strUnixSocket; }
+	CConnectionPool& getConnectionPool() noexcept { return connectionPool; }
+	const CConnectionPool& getConnectionPool() const noexcept { return connectionPool; }
+	
+ private:
+	friend class CUpstreamGroup;
+	
+	std::string strURL;
+	std::string strUnixSocket;
+	CConnectionPool connectionPool;
+	
+	std::atomic<size_t> iOutstanding{0};
+	std::atomic<size_t> iRequests{0};
+	std::atomic<size_t> iFailures{0};
+	std::atomic<size_t> iConsecutiveFailures{0};
+	std::atomic<size_t> iEjections{0};
+	std::atomic<std::int64_t> iEjectedUntil{0};
+	
+	// peak ewma in nanoseconds, written under mutexLatency and read lock-free
+	std::mutex mutexLatency;
+	std::atomic<double> dLatencyEwma{0.0};
+	std::atomic<std::int64_t> iLatencyUpdated{0};
+};
+
+// named set of interchangeable endpoints. callers address the group, the
+// worker picks an endpoint right before sending so the choice sees the
+// latest load and latency
+class CUpstreamGroup {
+ public:
+	CUpstreamGroup(std::string strName, const std::vector<std::string>& vecEndpointURLs, const UpstreamGroupConfig& config);
+	
+	CUpstreamGroup(const CUpstreamGroup&) = delete;
+	CUpstreamGroup& operator=(const CUpstreamGroup&) = delete;
+	
+	const std::string& getName() const noexcept { return strName; }
+	const UpstreamGroupConfig& getConfig() const noexcept { return config; }
+	size_t getEndpointCount() const noexcept { return vecEndpoints.size(); }
+	CUpstreamEndpoint& getEndpoint(size_t iIndex) noexcept { return *vecEndpoints[iIndex]; }
+	
+	// marks the returned endpoint as having one more request outstanding,
+	// every select() must be paired with a release()
+	CUpstreamEndpoint& select();
+	void release(CUpstreamEndpoint& endpoint, bool bFailed, std::chrono::nanoseconds timeLatency);
+	
+	std::vector<UpstreamEndpointStats> getStats() const;
+	
+	static bool isFailure(unsigned int iStatusCode) noexcept {
+		return iStatusCode == 0 || iStatusCode == 408 || iStatusCode >= 500;
+	}
+	
+ private:
+	static std::int64_t nowNanos() noexcept;
+	bool isEjected(const CUpstreamEndpoint& endpoint, std::int64_t iNow) const noexcept;
+	double latencyCost(const CUpstreamEndpoint& endpoint, std::int64_t iNow) const noexcept;
+	
+	std::string strName;
+	UpstreamGroupConfig config;
+	std::vector<std::unique_ptr<CUpstreamEndpoint>> vecEndpoints;
+	std::atomic<size_t> iNextEndpoint{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_UPSTREAM_GROUP_H_
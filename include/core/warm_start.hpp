@@ -0,0 +1,85 @@
+#ifndef HTTP_CLIENT_CPP_INCLUDE_CORE_WARM_START_H_
+#define HTTP_CLIENT_CPP_INCLUDE_CORE_WARM_START_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <curl/curl.h>
+
+class CDnsCache;
+
+struct WarmStartStats {
+	size_t iDnsEntries{0};
+	size_t iHstsEntries{0};
+	size_t iTlsSessions{0};
+};
+
+// state that lets a restarted client skip cold handshakes. every pooled
+// handle is attached to one curl share, so tls sessions are resumed across
+// connections. with a snapshot file the share also holds the hsts cache, and
+// sessions, hsts and resolved addresses are written to the file on shutdown
+// and read back at construction
+class CWarmStartState {
+ public:
+	explicit CWarmStartState(bool bPersistent);
+	~CWarmStartState();
+	
+	CWarmStartState(const CWarmStartState&) = delete;
+	CWarmStartState& operator=(const CWarmStartState&) = delete;
+	
+	CURLSH* getShare() const noexcept { return pShare; }
+	
+	// a missing or damaged file is not an error, the client just starts cold.
+	// returns whether anything was restored
+	bool load(const std::string& strPath, CDnsCache& dnsCache);
+	
+	// writes to a temporary file and renames it over strPath
+	bool save(const std::string& strPath, const CDnsCache& dnsCache);
+	
+	// what the last load restored
+	WarmStartStats getStats() const noexcept;
+	
+ private:
+	struct HstsEntry {
+		std::string strHost;
+		std::string strExpire;
+		bool bIncludeSubDomains{false};
+	};
+	
+	struct TlsSession {
+		std::string strKey;
+		std::string strMac;
+		std::string strData;
+	};
+	
+	static void lockShare(CURL* pHandle, curl_lock_data eData, curl_lock_access eAccess, void* pUser);
+	static void unlockShare(CURL* pHandle, curl_lock_data eData, void* pUser);
+	static CURLSTScode readHsts(CURL* pHandle, curl_hstsentry* pEntry, void* pUser);
+	static CURLSTScode writeHsts(CURL* pHandle, curl_hstsentry* pEntry, curl_index* pIndex, void* pUser);
+	
+	void importHsts();
+	void exportHsts();
+	void importTlsSessions();
+	void exportTlsSessions();
+	
+	CURLSH* pShare{nullptr};
+	std::mutex mutexSnapshot;
+	std::array<std::mutex, CURL_LOCK_DATA_LAST> arrShareLocks;
+	bool bPersistent{false};
+	
+	// staging for the shared caches, filled by load or by the export callbacks
+	std::vector<HstsEntry> vecHsts;
+	size_t iHstsCursor{0};
+	std::vector<TlsSession> vecTlsSessions;
+	
+	std::atomic<size_t> iDnsRestored{0};
+	std::atomic<size_t> iHstsRestored{0};
+	std::atomic<size_t> iTlsRestored{0};
+};
+
+#endif  // HTTP_CLIENT_CPP_INCLUDE_CORE_WARM_START_H_
@@ -2,6 +2,23 @@
 #define HTTP_CLIENT_CPP_INCLUDE_HTTP_CLIENT_H_
 
 #include "core/async_client.hpp"
+#include "core/autoscaler.hpp"
+#include "core/buffer_pool.hpp"
+#include "core/cancellation.hpp"
+#include "core/circuit_breaker.hpp"
+#include "core/compressor.hpp"
+#include "core/dns_cache.hpp"
+#include "core/handle_profile.hpp"
+#include "core/http1_codec.hpp"
+#include "core/intern_pool.hpp"
+#include "core/io_uring.hpp"
+#include "core/native_transport.hpp"
+#include "core/profiler.hpp"
+#include "core/request_body.hpp"
+#include "core/request_coalescer.hpp"
+#include "core/response_cache.hpp"
+#include "core/upstream_group.hpp"
+#include "core/warm_start.hpp"
 #include "utils/utils.hpp"
 
 #endif  // HTTP_CLIENT_CPP_INCLUDE_HTTP_CLIENT_H_
@@ -2,16 +2,30 @@
 #define HTTP_CLIENT_CPP_INCLUDE_UTILS_UTILS_H_
 
 #include <chrono>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+enum class HttpMethod : std::uint8_t {
+	Get,
+	Post,
+	Put,
+	Delete,
+	Head,
+	Options
+};
+
 class CUtils {
  public:
 	static std::string urlEncode(std::string_view strInput);
 	static std::string urlDecode(std::string_view strInput);
 	static std::string buildUrl(std::string_view strBase, std::string_view strEndpoint);
+	static std::string_view extractHost(std::string_view strUrl) noexcept;
+	static std::string_view extractHostName(std::string_view strUrl) noexcept;
+	static std::uint16_t extractPort(std::string_view strUrl) noexcept;
 	static std::vector<std::pair<std::string, std::string>> parseHeaders(std::string_view strHeaderString);
 	
 	static constexpr bool isValidHttpMethod(std::string_view strMethod) noexcept {
@@ -20,6 +34,28 @@ class CUtils {
 		       strMethod == "HEAD" || strMethod == "OPTIONS";
 	}
 	
+	static constexpr std::optional<HttpMethod> parseHttpMethod(std::string_view strMethod) noexcept {
+		if (strMethod == "GET") return HttpMethod::Get;
+		if (strMethod == "POST") return HttpMethod::Post;
+		if (strMethod == "PUT") return HttpMethod::Put;
+		if (strMethod == "DELETE") return HttpMethod::Delete;
+		if (strMethod == "HEAD") return HttpMethod::Head;
+		if (strMethod == "OPTIONS") return HttpMethod::Options;
+		return std::nullopt;
+	}
+	
+	static constexpr std::string_view httpMethodName(HttpMethod eMethod) noexcept {
+		switch (eMethod) {
+			case HttpMethod::Get: return "GET";
+			case HttpMethod::Post: return "POST";
+			case HttpMethod::Put: return "PUT";
+			case HttpMethod::Delete: return "DELETE";
+			case HttpMethod::Head: return "HEAD";
+			case HttpMethod::Options: return "OPTIONS";
+		}
+		return "GET";
+	}
+	
 	static constexpr bool isSuccessStatusCode(unsigned int iStatusCode) noexcept {
 		return iStatusCode >= 200 && iStatusCode < 300;
 	}
@@ -40,6 +76,9 @@ class CUtils {
 	static bool isValidHeaderValue(std::string_view strHeaderValue) noexcept;
 	static bool isValidHeader(std::string_view strHeaderName, std::string_view strHeaderValue) noexcept;
 	
+	// a filesystem path, or "@name" for the linux abstract namespace
+	static bool isValidUnixSocketPath(std::string_view strPath) noexcept;
+	
 	static bool isValidRequestSize(size_t iSize) noexcept;
 	static bool isValidTimeout(std::chrono::milliseconds timeout) noexcept;
 	static bool isValidWorkerCount(size_t iWorkerCount) noexcept;
@@ -52,6 +91,7 @@ class CUtils {
 	static constexpr size_t MAX_TIMEOUT_MS = 300000; 
 	static constexpr size_t MIN_WORKER_COUNT = 1;
 	static constexpr size_t MAX_WORKER_COUNT = 100;
+	static constexpr size_t MAX_UNIX_SOCKET_PATH_LENGTH = 107;
 };
 
 #endif  // HTTP_CLIENT_CPP_INCLUDE_UTILS_UTILS_H_
\ No newline at end of file
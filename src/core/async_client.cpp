@@ -2,50 +2,238 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
 #include <random>
 #include <sstream>
 
+#include <strings.h>
+
+#include "core/autoscaler.hpp"
+#include "core/circuit_breaker.hpp"
+#include "core/compressor.hpp"
+#include "core/dns_cache.hpp"
+#include "core/native_transport.hpp"
+#include "core/request_coalescer.hpp"
+#include "core/response_cache.hpp"
+#include "core/upstream_group.hpp"
+#include "core/warm_start.hpp"
 #include "utils/utils.hpp"
 
 std::unique_ptr<CWorkerPool> pGlobalPool = nullptr;
 
-static size_t writeCallback(void* pContents, size_t iSize, size_t iNmemb, std::string* pData) {
+namespace {
+
+struct HeaderListHash {
+	size_t operator()(const std::vector<std::pair<std::string, std::string>>& vecHeaders) const noexcept {
+		size_t iHash = vecHeaders.size();
+		for (const auto& header : vecHeaders) {
+			iHash ^= std::hash<std::string>{}(header.first) + 0x9e3779b97f4a7c15ULL + (iHash << 6) + (iHash >> 2);
+			iHash ^= std::hash<std::string>{}(header.second) + 0x9e3779b97f4a7c15ULL + (iHash << 6) + (iHash >> 2);
+		}
+		return iHash;
+	}
+};
+
+CInternPool<std::string, CStringHash>& getURLPool() {
+	static CInternPool<std::string, CStringHash> poolURLs;
+	return poolURLs;
+}
+
+CInternPool<std::vector<std::pair<std::string, std::string>>, HeaderListHash>& getHeaderPool() {
+	static CInternPool<std::vector<std::pair<std::string, std::string>>, HeaderListHash> poolHeaders;
+	return poolHeaders;
+}
+
+}  // namespace
+
+Request::Request(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, HttpMethod eMethod, std::string_view strBody) : Request(strURL, {}, vecHeaders, eMethod, CRequestBody()) {
+	size_t iStringsLength = strEndpoint.length() + strBody.length();
+	if (iStringsLength > 0) {
+		pStrings = std::make_unique_for_overwrite<char[]>(iStringsLength);
+		std::memcpy(pStrings.get(), strEndpoint.data(), strEndpoint.length());
+		std::memcpy(pStrings.get() + strEndpoint.length(), strBody.data(), strBody.length());
+	}
+	
+	iEndpointLength = static_cast<std::uint32_t>(strEndpoint.length());
+	if (!strBody.empty()) {
+		bodyRequest = CRequestBody::borrowed(std::string_view(pStrings.get() + iEndpointLength, strBody.length()));
+	}
+}
+
+Request::Request(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, HttpMethod eMethod, CRequestBody bodyRequest) : eMethod(eMethod), pBaseURL(getURLPool().intern(strURL)), iEndpointLength(static_cast<std::uint32_t>(strEndpoint.length())), bodyRequest(std::move(bodyRequest)), timeRequestTime(std::chrono::high_resolution_clock::now()) {
+	if (!strEndpoint.empty()) {
+		pStrings = std::make_unique_for_overwrite<char[]>(strEndpoint.length());
+		std::memcpy(pStrings.get(), strEndpoint.data(), strEndpoint.length());
+	}
+	setHeaders(vecHeaders);
+}
+
+const std::vector<std::pair<std::string, std::string>>& Request::getHeaders() const noexcept {
+	static const std::vector<std::pair<std::string, std::string>> vecEmpty;
+	return pHeaders ? *pHeaders : vecEmpty;
+}
+
+void Request::setHeaders(const std::vector<std::pair<std::string, std::string>>& vecHeaders) {
+	pHeaders = vecHeaders.empty() ? nullptr : getHeaderPool().intern(vecHeaders);
+}
+
+size_t Request::getInternedURLCount() {
+	return getURLPool().size();
+}
+
+size_t Request::getInternedHeaderSetCount() {
+	return getHeaderPool().size();
+}
+
+// per-transfer state shared by the write and header callbacks
+struct TransferSink {
+	Response* pResponse;
+	CBufferPool* pBufferPool;
+	size_t iHeaderCount;
+};
+
+static thread_local std::shared_ptr<CBufferPool> pThreadBufferPool;
+
+static size_t writeCallback(void* pContents, size_t iSize, size_t iNmemb, TransferSink* pSink) {
 	size_t iTotalSize = iSize * iNmemb;
-	pData->append(static_cast<char*>(pContents), iTotalSize);
+	std::string& strBody = pSink->pResponse->strBody;
+	
+	if (pSink->pBufferPool && strBody.size() + iTotalSize > strBody.capacity()) {
+		pSink->pBufferPool->reserve(strBody, std::max(strBody.size() + iTotalSize, strBody.size() * 2));
+	}
+	
+	strBody.append(static_cast<char*>(pContents), iTotalSize);
 	return iTotalSize;
 }
 
-static size_t headerCallback(char* pBuffer, size_t iSize, size_t iNmemb, std::vector<std::pair<std::string, std::string>>* pHeaders) {
+struct BodyCursor {
+	std::string_view strBody;
+	size_t iOffset;
+};
+
+static size_t readCallback(char* pBuffer, size_t iSize, size_t iNmemb, BodyCursor* pCursor) {
+	size_t iChunk = std::min(iSize * iNmemb, pCursor->strBody.length() - pCursor->iOffset);
+	std::memcpy(pBuffer, pCursor->strBody.data() + pCursor->iOffset, iChunk);
+	pCursor->iOffset += iChunk;
+	return iChunk;
+}
+
+static std::string_view trimHeaderPart(std::string_view strPart) noexcept {
+	size_t iStart = strPart.find_first_not_of(" \t");
+	if (iStart == std::string_view::npos) {
+		return {};
+	}
+	return strPart.substr(iStart, strPart.find_last_not_of(" \t") - iStart + 1);
+}
+
+static size_t headerCallback(char* pBuffer, size_t iSize, size_t iNmemb, TransferSink* pSink) {
 	size_t iTotalSize = iSize * iNmemb;
-    std::string_view strHeader(pBuffer, iTotalSize);
-  
-    if (!strHeader.empty() && strHeader.back() == '\n') {
-    	strHeader.remove_suffix(1);
-  	}
-  	if (!strHeader.empty() && strHeader.back() == '\r') {
-    	strHeader.remove_suffix(1);
-  	}
-  
-  	size_t iColonPos = strHeader.find(':');
-  	if (iColonPos != std::string_view::npos) {
-    	std::string strKey(strHeader.substr(0, iColonPos));
-    	std::string strValue(strHeader.substr(iColonPos + 1));
-    
-    	strKey.erase(0, strKey.find_first_not_of(" \t"));
-    	strKey.erase(strKey.find_last_not_of(" \t") + 1);
-    	strValue.erase(0, strValue.find_first_not_of(" \t"));
-    	strValue.erase(strValue.find_last_not_of(" \t") + 1);
-    
-    	pHeaders->emplace_back(std::move(strKey), std::move(strValue));
-  	}
-  
-  	return iTotalSize;
+	std::string_view strHeader(pBuffer, iTotalSize);
+	
+	if (!strHeader.empty() && strHeader.back() == '\n') {
+		strHeader.remove_suffix(1);
+	}
+	if (!strHeader.empty() && strHeader.back() == '\r') {
+		strHeader.remove_suffix(1);
+	}
+	
+	size_t iColonPos = strHeader.find(':');
+	if (iColonPos != std::string_view::npos) {
+		std::string_view strKey = trimHeaderPart(strHeader.substr(0, iColonPos));
+		std::string_view strValue = trimHeaderPart(strHeader.substr(iColonPos + 1));
+		
+		// recycled lists still carry strings from an earlier response, overwrite
+		// them in place so their buffers are reused
+		auto& vecHeaders = pSink->pResponse->vecHeaders;
+		if (pSink->iHeaderCount < vecHeaders.size()) {
+			vecHeaders[pSink->iHeaderCount].first.assign(strKey);
+			vecHeaders[pSink->iHeaderCount].second.assign(strValue);
+		} else {
+			vecHeaders.emplace_back(strKey, strValue);
+		}
+		++pSink->iHeaderCount;
+		
+		if (pSink->pBufferPool && strcasecmp(vecHeaders[pSink->iHeaderCount - 1].first.c_str(), "Content-Length") == 0) {
+			size_t iContentLength = 0;
+			auto result = std::from_chars(strValue.data(), strValue.data() + strValue.size(), iContentLength);
+			if (result.ec == std::errc{} && iContentLength <= CBufferPool::SIZE_CLASSES.back()) {
+				pSink->pBufferPool->reserve(pSink->pResponse->strBody, iContentLength);
+			}
+		}
+	}
+	
+	return iTotalSize;
+}
+
+static Response makeCancelledResponse(const Request& request) {
+	Response response;
+	response.timeRequestTime = request.timeRequestTime;
+	response.iStatusCode = 499;
+	response.eError = ResponseError::Cancelled;
+	response.strBody = "Request cancelled";
+	response.timeResponseTime = std::chrono::high_resolution_clock::now();
+	return response;
 }
 
-CWorkerPool::CWorkerPool(size_t iNumWorkers) : pConnectionPool(std::make_unique<CConnectionPool>()),vecWorkers(), bShutdownFlag(false), iPendingRequests(0), timeTimeout(1000), iMaxRetries(1), iConnectionPoolSize(50), iTotalRequests(0), iSuccessfulRequests(0), iFailedRequests(0) {
+// cancellable transfers run on a multi handle owned by the worker, so cancel()
+// can wake the poll instead of waiting for curl's next progress tick
+struct CancellableMulti {
+	CURLM* pMulti{curl_multi_init()};
+	
+	~CancellableMulti() {
+		if (pMulti) {
+			curl_multi_cleanup(pMulti);
+		}
+	}
+};
+
+static CURLcode performCancellable(CURL* pHandle, const CCancellationToken& tokenCancel) {
+	thread_local CancellableMulti cancellableMulti;
+	CURLM* pMulti = cancellableMulti.pMulti;
+	if (!pMulti || curl_multi_add_handle(pMulti, pHandle) != CURLM_OK) {
+		return curl_easy_perform(pHandle);
+	}
+	
+	tokenCancel.attachWaker(pMulti);
+	
+	CURLcode res = CURLE_ABORTED_BY_CALLBACK;
+	bool bDone = false;
+	while (!bDone && !tokenCancel.isCancelled()) {
+		int iRunning = 0;
+		if (curl_multi_perform(pMulti, &iRunning) != CURLM_OK) {
+			res = CURLE_RECV_ERROR;
+			break;
+		}
+		
+		int iQueued = 0;
+		while (CURLMsg* pMessage = curl_multi_info_read(pMulti, &iQueued)) {
+			if (pMessage->msg == CURLMSG_DONE && pMessage->easy_handle == pHandle) {
+				res = pMessage->data.result;
+				bDone = true;
+			}
+		}
+		
+		if (!bDone) {
+			curl_multi_poll(pMulti, nullptr, 0, 1000, nullptr);
+		}
+	}
+	
+	tokenCancel.detachWaker(pMulti);
+	
+	// removing an unfinished transfer aborts it, curl closes the connection
+	// and the handle is ready for the next request
+	curl_multi_remove_handle(pMulti, pHandle);
+	return res;
+}
+
+CWorkerPool::CWorkerPool(size_t iNumWorkers) : CWorkerPool(iNumWorkers, std::string_view()) {
+}
+
+CWorkerPool::CWorkerPool(size_t iNumWorkers, std::string_view strWarmStartFile) : pWarmStart(std::make_unique<CWarmStartState>(!strWarmStartFile.empty())), strWarmStartFile(strWarmStartFile), pConnectionPool(std::make_unique<CConnectionPool>()), pCoalescer(std::make_unique<CRequestCoalescer>()), pResponseCache(std::make_unique<CResponseCache>()), pCircuitBreaker(std::make_unique<CCircuitBreaker>()), pDnsCache(std::make_unique<CDnsCache>()), vecWorkers(), pAutoscaler(std::make_unique<CWorkerAutoscaler>()), pProfiler(std::make_unique<CHotPathProfiler>()), bShutdownFlag(false), iPendingRequests(0), timeTimeout(1000), iMaxRetries(1), iConnectionPoolSize(50), iTotalRequests(0), iSuccessfulRequests(0), iFailedRequests(0) {
   	if (!CUtils::isValidWorkerCount(iNumWorkers)) {
     	throw std::invalid_argument("Invalid worker count: " + std::to_string(iNumWorkers) + 
         	" (must be between " + std::to_string(CUtils::MIN_WORKER_COUNT) + 
@@ -53,11 +241,19 @@ CWorkerPool::CWorkerPool(size_t iNumWorkers) : pConnectionPool(std::make_unique<
   	}
   
   	curl_global_init(CURL_GLOBAL_DEFAULT);
-  	vecWorkers.reserve(iNumWorkers);
-  
-  	for (size_t i = 0; i < iNumWorkers; ++i) {
-    	vecWorkers.emplace_back(&CWorkerPool::workerLoop, this, i);
+  	
+  	if (!this->strWarmStartFile.empty()) {
+  		pWarmStart->load(this->strWarmStartFile, *pDnsCache);
   	}
+  	pConnectionPool->setShare(pWarmStart->getShare());
+  	queueRequests.setProfiler(pProfiler.get());
+  	pConnectionPool->setProfiler(pProfiler.get());
+  	mutexStats.attach(pProfiler.get());
+  	rebuildHandleProfile();
+  	
+  	resizeWorkers(iNumWorkers);
+  	
+  	threadMaintenance = std::thread(&CWorkerPool::maintenanceLoop, this);
 }
 
 CWorkerPool::~CWorkerPool() {
@@ -65,136 +261,364 @@ CWorkerPool::~CWorkerPool() {
 	curl_global_cleanup();
 }
 
-void CWorkerPool::workerLoop(size_t iWorkerId) {
-	Request request("", "", {}, "", "");
+void CWorkerPool::workerLoop(WorkerSlot* pSlot, size_t iWorkerId) {
+	{
+		// a pool left behind by a retired worker is picked up before a new one
+		std::lock_guard<CInstrumentedMutex> lock(mutexStats);
+		if (!vecIdleBufferPools.empty()) {
+			pThreadBufferPool = std::move(vecIdleBufferPools.back());
+			vecIdleBufferPools.pop_back();
+		} else {
+			pThreadBufferPool = std::make_shared<CBufferPool>();
+			vecBufferPools.push_back(pThreadBufferPool);
+		}
+	}
 	
-	while (!bShutdownFlag.load(std::memory_order_relaxed)) {
+	Request request;
+	
+	while (!bShutdownFlag.load(std::memory_order_relaxed) && !pSlot->bStopRequested.load(std::memory_order_relaxed)) {
 		if (queueRequests.dequeue_wait(request, std::chrono::milliseconds(100))) {  
+			auto timeQueued = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - request.timeRequestTime);
+			iQueueWaitMicros.fetch_add(static_cast<std::uint64_t>(std::max<std::int64_t>(timeQueued.count(), 0)), std::memory_order_relaxed);
+			iQueueWaitSamples.fetch_add(1, std::memory_order_relaxed);
+			iBusyWorkers.fetch_add(1, std::memory_order_relaxed);
+			
 			try {
 				processRequest(std::move(request));
 			} catch (const std::exception& e) {
 				std::cerr << "Worker " << iWorkerId << " exception: " << e.what() << std::endl;
 			}
 			
+			iBusyWorkers.fetch_sub(1, std::memory_order_relaxed);
 			iPendingRequests.fetch_sub(1, std::memory_order_relaxed);
 		}
 	}
+	
+	{
+		std::lock_guard<CInstrumentedMutex> lock(mutexStats);
+		vecIdleBufferPools.push_back(std::move(pThreadBufferPool));
+	}
+	pSlot->bExited.store(true, std::memory_order_release);
+}
+
+void CWorkerPool::resizeWorkers(size_t iTargetCount) {
+	std::vector<std::unique_ptr<WorkerSlot>> vecRetired;
+	
+	{
+		std::lock_guard<std::mutex> lock(mutexWorkers);
+		if (bShutdownFlag.load(std::memory_order_relaxed)) {
+			return;
+		}
+		
+		auto itExited = std::stable_partition(vecWorkers.begin(), vecWorkers.end(), [](const auto& pSlot) {
+			return !pSlot->bExited.load(std::memory_order_acquire);
+		});
+		std::move(itExited, vecWorkers.end(), std::back_inserter(vecRetired));
+		vecWorkers.erase(itExited, vecWorkers.end());
+		
+		size_t iRunning = std::count_if(vecWorkers.begin(), vecWorkers.end(), [](const auto& pSlot) {
+			return !pSlot->bStopRequested.load(std::memory_order_relaxed);
+		});
+		
+		while (iRunning < iTargetCount) {
+			auto pSlot = std::make_unique<WorkerSlot>();
+			pSlot->threadWorker = std::thread(&CWorkerPool::workerLoop, this, pSlot.get(), iNextWorkerId++);
+			vecWorkers.push_back(std::move(pSlot));
+			++iRunning;
+		}
+		
+		// the newest workers go first, their buffer pools are the coldest
+		for (auto it = vecWorkers.rbegin(); it != vecWorkers.rend() && iRunning > iTargetCount; ++it) {
+			if (!(*it)->bStopRequested.load(std::memory_order_relaxed)) {
+				(*it)->bStopRequested.store(true, std::memory_order_relaxed);
+				--iRunning;
+			}
+		}
+	}
+	
+	for (auto& pSlot : vecRetired) {
+		pSlot->threadWorker.join();
+	}
+}
+
+void CWorkerPool::autoscale() {
+	if (!bAutoscaling.load(std::memory_order_relaxed)) {
+		return;
+	}
+	
+	AutoscaleConfig config = pAutoscaler->getConfig();
+	auto timeNow = std::chrono::steady_clock::now();
+	if (timeNow - timeLastAutoscale < config.timeEvaluationInterval) {
+		return;
+	}
+	timeLastAutoscale = timeNow;
+	
+	WorkerLoadSample sample;
+	sample.iWorkers = getActiveWorkerCount();
+	sample.iBusyWorkers = std::min(iBusyWorkers.load(std::memory_order_relaxed), sample.iWorkers);
+	sample.iQueueDepth = queueRequests.size();
+	
+	std::uint64_t iSamples = iQueueWaitSamples.exchange(0, std::memory_order_relaxed);
+	std::uint64_t iWaitMicros = iQueueWaitMicros.exchange(0, std::memory_order_relaxed);
+	if (iSamples > 0) {
+		sample.timeAverageQueueWait = std::chrono::microseconds(iWaitMicros / iSamples);
+	}
+	
+	size_t iTarget = pAutoscaler->evaluate(sample, timeNow);
+	if (iTarget != sample.iWorkers) {
+		resizeWorkers(iTarget);
+	}
+}
+
+void CWorkerPool::maintenanceLoop() {
+	std::unique_lock<std::mutex> lock(mutexMaintenance);
+	
+	while (!bShutdownFlag.load(std::memory_order_relaxed)) {
+		auto timeTTL = timeIdleTTL.load(std::memory_order_relaxed);
+		auto timeInterval = std::clamp(timeTTL / 4, std::chrono::milliseconds(100), std::chrono::milliseconds(1000));
+		if (bAutoscaling.load(std::memory_order_relaxed)) {
+			timeInterval = std::min(timeInterval, std::max(pAutoscaler->getConfig().timeEvaluationInterval, std::chrono::milliseconds(10)));
+		}
+		
+		if (conditionMaintenance.wait_for(lock, timeInterval, [this] { return bShutdownFlag.load(std::memory_order_relaxed); })) {
+			break;
+		}
+		
+		lock.unlock();
+		autoscale();
+		pDnsCache->refreshExpiring();
+		
+		size_t iMinWarm = iMinWarmConnections.load(std::memory_order_relaxed);
+		pConnectionPool->reapIdleConnections(timeTTL, iMinWarm);
+		
+		std::vector<std::shared_ptr<CUpstreamGroup>> vecGroups;
+		{
+			std::lock_guard<std::mutex> lockUpstreams(mutexUpstreams);
+			for (const auto& [strName, pGroup] : mapUpstreamGroups) {
+				vecGroups.push_back(pGroup);
+			}
+		}
+		for (const auto& pGroup : vecGroups) {
+			for (size_t i = 0; i < pGroup->getEndpointCount(); ++i) {
+				pGroup->getEndpoint(i).getConnectionPool().reapIdleConnections(timeTTL, iMinWarm);
+			}
+		}
+		lock.lock();
+	}
 }
 
 void CWorkerPool::processRequest(Request&& request) {
-	Response response = executeHttpRequest(request);
-	request.promiseResponse.set_value(std::move(response));
+	// cancelled while queued, the worker moves straight on
+	if (request.tokenCancel.isCancelled()) {
+		completeRequest(request, makeCancelledResponse(request));
+		return;
+	}
+	
+	Response response = request.pUpstreamGroup ? executeUpstreamRequest(request) : executeGuardedRequest(request, request.getURL(), *pConnectionPool, findUnixSocket(request.getURL()));
+	bool bSuccess = response.isSuccess();
+	bool bError = response.isError();
+	
+	completeRequest(request, std::move(response));
 	
 	{
-		std::lock_guard<std::mutex> lock(mutexStats);
+		std::lock_guard<CInstrumentedMutex> lock(mutexStats);
 		iTotalRequests.fetch_add(1, std::memory_order_relaxed);
 		
-		if (response.isSuccess()) {
+		if (bSuccess) {
 			iSuccessfulRequests.fetch_add(1, std::memory_order_relaxed);
-		} else if (response.isError()) {
+		} else if (bError) {
 			iFailedRequests.fetch_add(1, std::memory_order_relaxed);
 		}
 	}
 }
 
-Response CWorkerPool::executeHttpRequest(const Request& request) {
+void CWorkerPool::completeRequest(Request& request, Response&& response) {
+	CStageTimer timerCompletion(pProfiler.get(), ProfileStage::Completion);
+	if (request.fnOnComplete) {
+		request.fnOnComplete(request, response);
+	}
+	request.promiseResponse.set_value(std::move(response));
+}
+
+static Response makeCircuitOpenResponse(const Request& request) {
+	Response response;
+	response.timeRequestTime = request.timeRequestTime;
+	response.iStatusCode = 503;
+	response.eError = ResponseError::CircuitOpen;
+	response.strBody = "Circuit open";
+	response.timeResponseTime = std::chrono::high_resolution_clock::now();
+	return response;
+}
+
+Response CWorkerPool::executeGuardedRequest(const Request& request, std::string_view strBaseURL, CConnectionPool& connectionPool, std::string_view strUnixSocket) {
+	if (!bCircuitBreaking.load(std::memory_order_relaxed)) {
+		return executeHttpRequest(request, strBaseURL, connectionPool, strUnixSocket);
+	}
+	
+	// checked again at dequeue, the circuit may have opened while we queued
+	std::string strHost = CConnectionPool::buildKey(CUtils::extractHost(strBaseURL), strUnixSocket);
+	CCircuitBreaker::Admission eAdmission = pCircuitBreaker->tryAcquire(strHost);
+	if (eAdmission == CCircuitBreaker::Admission::Rejected) {
+		return makeCircuitOpenResponse(request);
+	}
+	
+	Response response = executeHttpRequest(request, strBaseURL, connectionPool, strUnixSocket);
+	pCircuitBreaker->record(strHost, eAdmission, CCircuitBreaker::isFailure(response));
+	return response;
+}
+
+Response CWorkerPool::executeUpstreamRequest(const Request& request) {
+	CUpstreamGroup& upstreamGroup = *request.pUpstreamGroup;
+	CUpstreamEndpoint& endpoint = upstreamGroup.select();
+	
+	auto timeStart = std::chrono::steady_clock::now();
+	std::string strUnixSocket = endpoint.getUnixSocket().empty() ? findUnixSocket(endpoint.getURL()) : endpoint.getUnixSocket();
+	Response response = executeGuardedRequest(request, endpoint.getURL(), endpoint.getConnectionPool(), strUnixSocket);
+	upstreamGroup.release(endpoint, CUpstreamGroup::isFailure(response.iStatusCode), std::chrono::steady_clock::now() - timeStart);
+	
+	return response;
+}
+
+std::string CWorkerPool::findUnixSocket(std::string_view strBaseURL) const {
+	if (!bUnixSocketRoutes.load(std::memory_order_relaxed)) {
+		return {};
+	}
+	
+	std::shared_lock<std::shared_mutex> lock(mutexUnixSockets);
+	auto it = mapUnixSockets.find(CUtils::extractHost(strBaseURL));
+	return it == mapUnixSockets.end() ? std::string() : it->second;
+}
+
+Response CWorkerPool::executeHttpRequest(const Request& request, std::string_view strBaseURL, CConnectionPool& connectionPool, std::string_view strUnixSocket) {
 	Response response;
 	response.timeRequestTime = request.timeRequestTime;
 	
 	try {
-		std::string strFullURL = CUtils::buildUrl(request.strURL, request.strEndpoint);
+		std::string strFullURL = CUtils::buildUrl(strBaseURL, request.getEndpoint());
 		
-		size_t iProtocolPos = strFullURL.find("://");
-		if (iProtocolPos == std::string::npos) {
+		if (strFullURL.find("://") == std::string::npos) {
 			response.iStatusCode = 400;
 			response.strBody = "Invalid URL";
 			response.timeResponseTime = std::chrono::high_resolution_clock::now();
 			return response;
 		}
 		
-		size_t iHostStart = iProtocolPos + 3;
-		size_t iPathStart = strFullURL.find('/', iHostStart);
+		// plaintext requests skip curl entirely unless their body would be
+		// compressed, which only the curl path does. a native exchange cannot
+		// be interrupted, so cancellable requests stay on curl as well
+		if (bNativeTransport.load(std::memory_order_relaxed) && !request.tokenCancel && strUnixSocket.empty() && CNativeHttpTransport::supports(strFullURL)) {
+			size_t iThreshold = iCompressionThreshold.load(std::memory_order_relaxed);
+			bool bCompressBody = iThreshold > 0 && request.bodyRequest.size() >= iThreshold && 
+			                     (request.eMethod == HttpMethod::Post || request.eMethod == HttpMethod::Put);
+			
+			if (!bCompressBody) {
+				thread_local CNativeHttpTransport nativeTransport;
+				
+				CBufferPool* pBufferPool = nullptr;
+				if (bPoolResponseBuffers.load(std::memory_order_relaxed) && pThreadBufferPool) {
+					response.pBufferPool = pThreadBufferPool;
+					pBufferPool = pThreadBufferPool.get();
+				}
+				
+				CDnsCache* pResolver = pDnsCache->isActive() ? pDnsCache.get() : nullptr;
+				CNativeHttpTransport::Result eResult;
+				{
+					CStageTimer timerTransfer(pProfiler.get(), ProfileStage::Transfer);
+					eResult = nativeTransport.perform(request, strFullURL, response, pBufferPool, timeTimeout, pResolver);
+				}
+				if (eResult == CNativeHttpTransport::Result::Completed) {
+					response.timeResponseTime = std::chrono::high_resolution_clock::now();
+					return response;
+				}
+			}
+		}
 		
-		std::string strHost = strFullURL.substr(iHostStart, iPathStart - iHostStart);
+		std::string strHost = CConnectionPool::buildKey(CUtils::extractHost(strFullURL), strUnixSocket);
 		
-		CURL* pHandle = pConnectionPool->getConnection(strHost);
-		if (!pHandle) {
-			pHandle = curl_easy_init();
-			if (!pHandle) {
-				response.iStatusCode = 500;
-				response.strBody = "Failed to initialize CURL";
-				response.timeResponseTime = std::chrono::high_resolution_clock::now();
-				return response;
-			}
-			curl_easy_setopt(pHandle, CURLOPT_TCP_NODELAY, 1L);
-			curl_easy_setopt(pHandle, CURLOPT_TCP_FASTOPEN, 1L);
-			curl_easy_setopt(pHandle, CURLOPT_MAXREDIRS, 3L);
-			curl_easy_setopt(pHandle, CURLOPT_FOLLOWLOCATION, 1L);
-			curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYPEER, 0L);
-			curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYHOST, 0L);
-			curl_easy_setopt(pHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeTimeout.count()));
-			curl_easy_setopt(pHandle, CURLOPT_CONNECTTIMEOUT_MS, 500L);
-			curl_easy_setopt(pHandle, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
+		// handed back to the pool on every way out of here, exceptions included
+		CConnectionPool::Lease lease = [&] {
+			CStageTimer timerCheckout(pProfiler.get(), ProfileStage::Checkout);
+			return connectionPool.acquire(strHost);
+		}();
+		if (!lease) {
+			response.iStatusCode = 500;
+			response.strBody = "Failed to initialize CURL";
+			response.timeResponseTime = std::chrono::high_resolution_clock::now();
+			return response;
 		}
+		CURL* pHandle = lease.get();
+		CHandleState& handleState = lease.getState();
 		
-		curl_easy_reset(pHandle);
+		// options shared by every request are set once per handle, the rest
+		// only when they differ from what the last request on it left behind
+		std::shared_ptr<const CHandleProfile> pProfile = pHandleProfile.load(std::memory_order_acquire);
+		pProfile->bind(pHandle, handleState);
 		
 		curl_easy_setopt(pHandle, CURLOPT_URL, strFullURL.c_str());
-		curl_easy_setopt(pHandle, CURLOPT_WRITEFUNCTION, writeCallback);
-		curl_easy_setopt(pHandle, CURLOPT_WRITEDATA, &response.strBody);
-		curl_easy_setopt(pHandle, CURLOPT_HEADERFUNCTION, headerCallback);
-		curl_easy_setopt(pHandle, CURLOPT_HEADERDATA, &response.vecHeaders);
-		curl_easy_setopt(pHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeTimeout.count()));
-		curl_easy_setopt(pHandle, CURLOPT_CONNECTTIMEOUT_MS, 500L);
-		curl_easy_setopt(pHandle, CURLOPT_TCP_NODELAY, 1L);
-		curl_easy_setopt(pHandle, CURLOPT_TCP_FASTOPEN, 1L);
-		curl_easy_setopt(pHandle, CURLOPT_FOLLOWLOCATION, 1L);
-		curl_easy_setopt(pHandle, CURLOPT_MAXREDIRS, 3L);
-		curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYPEER, 0L);
-		curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYHOST, 0L);
-		curl_easy_setopt(pHandle, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
+		TransferSink transferSink{&response, nullptr, 0};
+		if (bPoolResponseBuffers.load(std::memory_order_relaxed) && pThreadBufferPool) {
+			response.pBufferPool = pThreadBufferPool;
+			response.vecHeaders = pThreadBufferPool->acquireHeaders();
+			transferSink.pBufferPool = pThreadBufferPool.get();
+		}
+		curl_easy_setopt(pHandle, CURLOPT_WRITEDATA, &transferSink);
+		curl_easy_setopt(pHandle, CURLOPT_HEADERDATA, &transferSink);
+		handleState.setUnixSocket(pHandle, strUnixSocket);
 		
-		if (!CUtils::isValidHttpMethod(request.strMethod)) {
-			response.iStatusCode = 400;
-			response.strBody = "Invalid HTTP method: " + request.strMethod;
-			response.timeResponseTime = std::chrono::high_resolution_clock::now();
-			pConnectionPool->returnConnection(pHandle);
-			return response;
+		// cached addresses go in as a resolve entry so curl skips its own lookup
+		std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> pResolveList(nullptr, curl_slist_free_all);
+		if (strUnixSocket.empty() && pDnsCache->isActive()) {
+			std::string strResolve = pDnsCache->formatResolveEntry(CUtils::extractHostName(strFullURL), CUtils::extractPort(strFullURL));
+			if (!strResolve.empty()) {
+				pResolveList.reset(curl_slist_append(nullptr, strResolve.c_str()));
+			}
 		}
+		handleState.setResolve(pHandle, pResolveList.get());
+		
+		std::string_view strBody = request.bodyRequest.view();
+		bool bStreamBody = request.bodyRequest.isStreamed();
+		bool bCompressedBody = false;
 		
-		if (request.strMethod == "GET") {
-			curl_easy_setopt(pHandle, CURLOPT_HTTPGET, 1L);
-		} else if (request.strMethod == "POST") {
-			curl_easy_setopt(pHandle, CURLOPT_POST, 1L);
-			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, request.strBody.c_str());
-			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, request.strBody.length());
-		} else if (request.strMethod == "PUT") {
-			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "PUT");
-			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, request.strBody.c_str());
-			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, request.strBody.length());
-		} else if (request.strMethod == "DELETE") {
-			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "DELETE");
-		} else if (request.strMethod == "HEAD") {
-			curl_easy_setopt(pHandle, CURLOPT_NOBODY, 1L);
-		} else if (request.strMethod == "OPTIONS") {
-			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "OPTIONS");
+		size_t iThreshold = iCompressionThreshold.load(std::memory_order_relaxed);
+		if (iThreshold > 0 && strBody.length() >= iThreshold && 
+		    (request.eMethod == HttpMethod::Post || request.eMethod == HttpMethod::Put) && 
+		    std::none_of(request.getHeaders().begin(), request.getHeaders().end(), [](const auto& header) {
+		        return strcasecmp(header.first.c_str(), "Content-Encoding") == 0;
+		    })) {
+			thread_local CGzipCompressor gzipCompressor;
+			
+			std::string_view strCompressed = gzipCompressor.compress(strBody);
+			if (!strCompressed.empty() && strCompressed.length() < strBody.length()) {
+				strBody = strCompressed;
+				bStreamBody = false;
+				bCompressedBody = true;
+			}
 		}
 		
-		struct curl_slist* pCurlHeaders = nullptr;
-		for (const auto& header : request.vecHeaders) {
+		BodyCursor bodyCursor{strBody, 0};
+		curl_off_t iStreamSize = request.bodyRequest.isChunked() ? -1 : static_cast<curl_off_t>(strBody.length());
+		
+		handleState.setMethod(pHandle, request.eMethod, bStreamBody);
+		handleState.setBody(pHandle, strBody, &bodyCursor, iStreamSize);
+		
+		std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> pCurlHeaders(nullptr, curl_slist_free_all);
+		for (const auto& header : request.getHeaders()) {
 			std::string strHeaderLine = header.first + ": " + header.second;
-			pCurlHeaders = curl_slist_append(pCurlHeaders, strHeaderLine.c_str());
+			pCurlHeaders.reset(curl_slist_append(pCurlHeaders.release(), strHeaderLine.c_str()));
 		}
 		
-		if (pCurlHeaders) {
-			curl_easy_setopt(pHandle, CURLOPT_HTTPHEADER, pCurlHeaders);
+		if (bCompressedBody) {
+			pCurlHeaders.reset(curl_slist_append(pCurlHeaders.release(), "Content-Encoding: gzip"));
 		}
+		handleState.setHeaders(pHandle, pCurlHeaders.get());
 		
-		CURLcode res = curl_easy_perform(pHandle);
-		
-		if (pCurlHeaders) {
-			curl_slist_free_all(pCurlHeaders);
+		CURLcode res;
+		{
+			CStageTimer timerTransfer(pProfiler.get(), ProfileStage::Transfer);
+			res = request.tokenCancel ? performCancellable(pHandle, request.tokenCancel) : curl_easy_perform(pHandle);
 		}
+		handleState.complete();
+		response.vecHeaders.resize(transferSink.iHeaderCount);
 		
 		if (res == CURLE_OK) {
 			long httpCode = 0;
@@ -204,19 +628,29 @@ Response CWorkerPool::executeHttpRequest(const Request& request) {
 			switch (res) {
 				case CURLE_OPERATION_TIMEDOUT:
 					response.iStatusCode = 408;  
+					response.eError = ResponseError::Timeout;
 					response.strBody = "Request timeout";
 					break;
 				case CURLE_COULDNT_CONNECT:
 				case CURLE_COULDNT_RESOLVE_HOST:
 					response.iStatusCode = 503; 
+					response.eError = ResponseError::ConnectFailed;
 					response.strBody = "Connection failed";
 					break;
 				case CURLE_SSL_CONNECT_ERROR:
 					response.iStatusCode = 502;
+					response.eError = ResponseError::TlsFailed;
 					response.strBody = "SSL connection error";
 					break;
+				case CURLE_ABORTED_BY_CALLBACK:
+					response.iStatusCode = 499;
+					response.eError = ResponseError::Cancelled;
+					response.strBody = "Request cancelled";
+					response.vecHeaders.clear();
+					break;
 				default:
 					response.iStatusCode = 500; 
+					response.eError = ResponseError::TransportFailed;
 					response.strBody = "CURL error: " + std::string(curl_easy_strerror(res));
 					break;
 			}
@@ -224,8 +658,6 @@ Response CWorkerPool::executeHttpRequest(const Request& request) {
 		
 		response.timeResponseTime = std::chrono::high_resolution_clock::now();
 		
-		pConnectionPool->returnConnection(pHandle);
-		
 	} catch (const std::exception& e) {
 		response.iStatusCode = 500;
 		response.strBody = "Exception: " + std::string(e.what());
@@ -242,15 +674,34 @@ Response CWorkerPool::executeHttpRequest(const Request& request) {
 void CWorkerPool::submitRequest(Request&& request) {
 	constexpr size_t MAX_QUEUE_SIZE = 10000;
 	
+	if (request.tokenCancel.isCancelled()) {
+		completeRequest(request, makeCancelledResponse(request));
+		return;
+	}
+	
 	if (queueRequests.size() >= MAX_QUEUE_SIZE) {
 		Response errorResponse;
 		errorResponse.iStatusCode = 503;
+		errorResponse.eError = ResponseError::QueueFull;
 		errorResponse.strBody = "Service temporarily unavailable - queue full";
 		errorResponse.timeResponseTime = std::chrono::high_resolution_clock::now();
-		request.promiseResponse.set_value(std::move(errorResponse));
+		completeRequest(request, std::move(errorResponse));
 		return;
 	}
 	
+	// an open circuit fails fast instead of holding a worker for the timeout
+	std::string strUnixSocket = request.pUpstreamGroup ? std::string() : findUnixSocket(request.getURL());
+	if (bCircuitBreaking.load(std::memory_order_relaxed) && !request.pUpstreamGroup && 
+	    pCircuitBreaker->rejectIfOpen(CConnectionPool::buildKey(CUtils::extractHost(request.getURL()), strUnixSocket))) {
+		completeRequest(request, makeCircuitOpenResponse(request));
+		return;
+	}
+	
+	// starts the lookup while the request waits in the queue
+	if (!request.pUpstreamGroup && strUnixSocket.empty()) {
+		pDnsCache->prefetch(CUtils::extractHostName(request.getURL()));
+	}
+	
 	size_t pendingCount = iPendingRequests.load(std::memory_order_relaxed);
 	if (pendingCount > 5000) { 
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
@@ -266,71 +717,132 @@ std::future<Response> CWorkerPool::submitRequestAsync(Request&& request) {
 	return future;
 }
 
-std::future<Response> CWorkerPool::getAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders) {
-	if (!CUtils::isValidHttpMethod("GET")) {
-		throw std::invalid_argument("Invalid HTTP method: GET");
+HttpMethod CWorkerPool::validateRequest(std::string_view strMethod, const std::string& strFullURL, const std::vector<std::pair<std::string, std::string>>& vecHeaders, size_t iBufferedBodySize) {
+	auto eMethod = CUtils::parseHttpMethod(strMethod);
+	if (!eMethod) {
+		throw std::invalid_argument("Invalid HTTP method: " + std::string(strMethod));
 	}
 	
-	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
 	if (!CUtils::isValidUrl(strFullURL)) {
 		throw std::invalid_argument("Invalid URL: " + strFullURL);
 	}
 	
+	if (!CUtils::isValidRequestSize(iBufferedBodySize)) {
+		throw std::invalid_argument("Request body too large: " + std::to_string(iBufferedBodySize) + " bytes");
+	}
+	
 	for (const auto& header : vecHeaders) {
 		if (!CUtils::isValidHeader(header.first, header.second)) {
 			throw std::invalid_argument("Invalid header: " + header.first + ": " + header.second);
 		}
 	}
 	
-	Request request(std::string(strURL), std::string(strEndpoint), vecHeaders, "GET", "");
-	return submitRequestAsync(std::move(request));
+	return *eMethod;
 }
 
-std::future<Response> CWorkerPool::postAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strBody) {
-	if (!CUtils::isValidHttpMethod("POST")) {
-		throw std::invalid_argument("Invalid HTTP method: POST");
-	}
-	
+std::future<Response> CWorkerPool::getAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders) {
 	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
-	if (!CUtils::isValidUrl(strFullURL)) {
-		throw std::invalid_argument("Invalid URL: " + strFullURL);
+	validateRequest("GET", strFullURL, vecHeaders, 0);
+	
+	Request request(strURL, strEndpoint, vecHeaders, HttpMethod::Get);
+	if (serveFromCache(strFullURL, request)) {
+		return request.promiseResponse.get_future();
 	}
 	
-	if (!CUtils::isValidRequestSize(strBody.length())) {
-		throw std::invalid_argument("Request body too large: " + std::to_string(strBody.length()) + " bytes");
+	if (!bCoalesceRequests.load(std::memory_order_relaxed)) {
+		return submitRequestAsync(std::move(request));
 	}
 	
-	for (const auto& header : vecHeaders) {
-		if (!CUtils::isValidHeader(header.first, header.second)) {
-			throw std::invalid_argument("Invalid header: " + header.first + ": " + header.second);
-		}
+	std::future<Response> future;
+	if (pCoalescer->join(pCoalescer->buildKey("GET", strFullURL, vecHeaders), request, future)) {
+		submitRequest(std::move(request));
 	}
+	return future;
+}
+
+std::future<Response> CWorkerPool::getAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CCancellationToken tokenCancel) {
+	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
+	validateRequest("GET", strFullURL, vecHeaders, 0);
 	
-	Request request(std::string(strURL), std::string(strEndpoint), vecHeaders, "POST", std::string(strBody));
+	Request request(strURL, strEndpoint, vecHeaders, HttpMethod::Get);
+	request.tokenCancel = std::move(tokenCancel);
+	if (serveFromCache(strFullURL, request)) {
+		return request.promiseResponse.get_future();
+	}
 	return submitRequestAsync(std::move(request));
 }
 
-std::future<Response> CWorkerPool::requestAsync(std::string_view strMethod, std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strBody) {
-	if (!CUtils::isValidHttpMethod(strMethod)) {
-		throw std::invalid_argument("Invalid HTTP method: " + std::string(strMethod));
+std::shared_future<Response> CWorkerPool::getSharedAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders) {
+	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
+	validateRequest("GET", strFullURL, vecHeaders, 0);
+	
+	Request request(strURL, strEndpoint, vecHeaders, HttpMethod::Get);
+	if (serveFromCache(strFullURL, request)) {
+		return request.promiseResponse.get_future().share();
 	}
 	
-	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
-	if (!CUtils::isValidUrl(strFullURL)) {
-		throw std::invalid_argument("Invalid URL: " + strFullURL);
+	std::shared_future<Response> future;
+	if (pCoalescer->joinShared(pCoalescer->buildKey("GET", strFullURL, vecHeaders), request, future)) {
+		submitRequest(std::move(request));
 	}
+	return future;
+}
+
+bool CWorkerPool::serveFromCache(const std::string& strFullURL, Request& request) {
+	if (!pResponseCache->isEnabled() || !CResponseCache::isCacheableRequest(request.getHeaders())) {
+		return false;
+	}
+	
+	std::shared_ptr<const Response> pCached;
+	auto eResult = pResponseCache->lookup(strFullURL, request.getHeaders(), pCached);
 	
-	if (!CUtils::isValidRequestSize(strBody.length())) {
-		throw std::invalid_argument("Request body too large: " + std::to_string(strBody.length()) + " bytes");
+	if (eResult == CResponseCache::LookupResult::Fresh) {
+		Response response = *pCached;
+		response.timeRequestTime = request.timeRequestTime;
+		response.timeResponseTime = std::chrono::high_resolution_clock::now();
+		completeRequest(request, std::move(response));
+		return true;
 	}
 	
-	for (const auto& header : vecHeaders) {
-		if (!CUtils::isValidHeader(header.first, header.second)) {
-			throw std::invalid_argument("Invalid header: " + header.first + ": " + header.second);
-		}
+	if (eResult == CResponseCache::LookupResult::Stale) {
+		auto vecHeaders = request.getHeaders();
+		CResponseCache::addValidators(*pCached, vecHeaders);
+		request.setHeaders(vecHeaders);
+		pResponseCache->attach(strFullURL, request, std::move(pCached));
+	} else {
+		pResponseCache->attach(strFullURL, request);
 	}
+	return false;
+}
+
+std::future<Response> CWorkerPool::postAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strBody) {
+	return requestAsync("POST", strURL, strEndpoint, vecHeaders, strBody);
+}
+
+std::future<Response> CWorkerPool::postAsync(std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CRequestBody bodyRequest) {
+	return requestAsync("POST", strURL, strEndpoint, vecHeaders, std::move(bodyRequest));
+}
+
+std::future<Response> CWorkerPool::requestAsync(std::string_view strMethod, std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strBody) {
+	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
+	HttpMethod eMethod = validateRequest(strMethod, strFullURL, vecHeaders, strBody.length());
+	
+	Request request(strURL, strEndpoint, vecHeaders, eMethod, strBody);
+	return submitRequestAsync(std::move(request));
+}
+
+std::future<Response> CWorkerPool::requestAsync(std::string_view strMethod, std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CRequestBody bodyRequest) {
+	return requestAsync(strMethod, strURL, strEndpoint, vecHeaders, std::move(bodyRequest), CCancellationToken());
+}
+
+std::future<Response> CWorkerPool::requestAsync(std::string_view strMethod, std::string_view strURL, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CRequestBody bodyRequest, CCancellationToken tokenCancel) {
+	std::string strFullURL = CUtils::buildUrl(strURL, strEndpoint);
 	
-	Request request(std::string(strURL), std::string(strEndpoint), vecHeaders, std::string(strMethod), std::string(strBody));
+	// streamed bodies never sit in memory as a whole, the limit is for buffers
+	HttpMethod eMethod = validateRequest(strMethod, strFullURL, vecHeaders, bodyRequest.isStreamed() ? 0 : bodyRequest.size());
+	
+	Request request(strURL, strEndpoint, vecHeaders, eMethod, std::move(bodyRequest));
+	request.tokenCancel = std::move(tokenCancel);
 	return submitRequestAsync(std::move(request));
 }
 
@@ -374,6 +886,7 @@ void CWorkerPool::setTimeout(std::chrono::milliseconds timeout) noexcept {
 	} else {
 		timeTimeout = std::chrono::milliseconds(1000);
 	}
+	rebuildHandleProfile();
 }
 
 void CWorkerPool::setMaxRetries(size_t iMaxRetries) noexcept {
@@ -392,12 +905,320 @@ void CWorkerPool::setConnectionPoolSize(size_t iPoolSize) noexcept {
 	}
 }
 
+void CWorkerPool::setIdleConnectionTTL(std::chrono::milliseconds timeIdleTTL) noexcept {
+	if (CUtils::isValidTimeout(timeIdleTTL)) {
+		this->timeIdleTTL.store(timeIdleTTL, std::memory_order_relaxed);
+	} else {
+		this->timeIdleTTL.store(std::chrono::milliseconds(60000), std::memory_order_relaxed);
+	}
+}
+
+void CWorkerPool::setMinWarmConnections(size_t iMinWarm) noexcept {
+	if (iMinWarm <= 50) {
+		iMinWarmConnections.store(iMinWarm, std::memory_order_relaxed);
+	} else {
+		iMinWarmConnections.store(1, std::memory_order_relaxed);
+	}
+}
+
+void CWorkerPool::setRequestCoalescing(bool bEnabled) noexcept {
+	bCoalesceRequests.store(bEnabled, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setCoalescingHeaders(std::vector<std::string> vecHeaderNames) {
+	pCoalescer->setKeyHeaders(std::move(vecHeaderNames));
+}
+
+void CWorkerPool::setResponseDecompression(bool bEnabled) noexcept {
+	bAcceptEncoding.store(bEnabled, std::memory_order_relaxed);
+	rebuildHandleProfile();
+}
+
+void CWorkerPool::rebuildHandleProfile() {
+	std::lock_guard<std::mutex> lock(mutexHandleProfile);
+	
+	CHandleProfile::Settings settings;
+	settings.timeTimeout = timeTimeout;
+	settings.bAcceptEncoding = bAcceptEncoding.load(std::memory_order_relaxed);
+	settings.fnWrite = reinterpret_cast<curl_write_callback>(writeCallback);
+	settings.fnHeader = reinterpret_cast<curl_write_callback>(headerCallback);
+	settings.fnRead = reinterpret_cast<curl_read_callback>(readCallback);
+	
+	// handles move over lazily, each resets once on its next request
+	pHandleProfile.store(std::make_shared<const CHandleProfile>(settings), std::memory_order_release);
+}
+
+void CWorkerPool::setRequestCompression(size_t iMinBodySize) noexcept {
+	iCompressionThreshold.store(iMinBodySize, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setResponseBufferPooling(bool bEnabled) noexcept {
+	bPoolResponseBuffers.store(bEnabled, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setNativeTransport(bool bEnabled) noexcept {
+	bNativeTransport.store(bEnabled, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setCircuitBreaker(bool bEnabled) noexcept {
+	bCircuitBreaking.store(bEnabled, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setAutoscaling(bool bEnabled) noexcept {
+	bAutoscaling.store(bEnabled, std::memory_order_relaxed);
+}
+
+void CWorkerPool::setDnsCaching(bool bEnabled) noexcept {
+	pDnsCache->setEnabled(bEnabled);
+}
+
+void CWorkerPool::setDnsCacheConfig(const DnsCacheConfig& config) {
+	pDnsCache->setConfig(config);
+}
+
+void CWorkerPool::setDnsOverride(std::string_view strHost, const std::vector<std::string>& vecAddresses) {
+	pDnsCache->setOverride(strHost, vecAddresses);
+}
+
+void CWorkerPool::setUnixSocket(std::string_view strAuthority, std::string_view strSocketPath) {
+	if (strAuthority.empty() || strAuthority.find_first_of("/?#") != std::string_view::npos) {
+		throw std::invalid_argument("Invalid authority for unix socket route: " + std::string(strAuthority));
+	}
+	if (!strSocketPath.empty() && !CUtils::isValidUnixSocketPath(strSocketPath)) {
+		throw std::invalid_argument("Invalid unix socket path: " + std::string(strSocketPath));
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(mutexUnixSockets);
+	if (strSocketPath.empty()) {
+		auto it = mapUnixSockets.find(strAuthority);
+		if (it != mapUnixSockets.end()) {
+			mapUnixSockets.erase(it);
+		}
+	} else {
+		mapUnixSockets.insert_or_assign(std::string(strAuthority), std::string(strSocketPath));
+	}
+	bUnixSocketRoutes.store(!mapUnixSockets.empty(), std::memory_order_relaxed);
+}
+
+void CWorkerPool::setAutoscaleConfig(const AutoscaleConfig& config) {
+	if (config.iMinWorkers < CUtils::MIN_WORKER_COUNT || config.iMaxWorkers > CUtils::MAX_WORKER_COUNT || config.iMinWorkers > config.iMaxWorkers) {
+		throw std::invalid_argument("Invalid autoscale bounds: " + std::to_string(config.iMinWorkers) + ".." + std::to_string(config.iMaxWorkers) + 
+			" (must be within " + std::to_string(CUtils::MIN_WORKER_COUNT) + ".." + std::to_string(CUtils::MAX_WORKER_COUNT) + ")");
+	}
+	if (config.dScaleDownBusyRatio <= 0.0 || config.dScaleDownBusyRatio > config.dScaleUpBusyRatio || config.dScaleUpBusyRatio > 1.0) {
+		throw std::invalid_argument("Invalid autoscale busy ratios");
+	}
+	if (config.timeEvaluationInterval.count() <= 0) {
+		throw std::invalid_argument("Invalid autoscale evaluation interval");
+	}
+	pAutoscaler->setConfig(config);
+}
+
+void CWorkerPool::setCircuitBreakerConfig(const CircuitBreakerConfig& config) {
+	if (config.dFailureRate <= 0.0 || config.dFailureRate > 1.0) {
+		throw std::invalid_argument("Invalid circuit breaker failure rate: " + std::to_string(config.dFailureRate));
+	}
+	if (config.iHalfOpenProbes == 0) {
+		throw std::invalid_argument("Circuit breaker needs at least one half-open probe");
+	}
+	pCircuitBreaker->setConfig(config);
+}
+
+void CWorkerPool::setResponseCacheSize(size_t iMaxBytes) {
+	pResponseCache->setMaxBytes(iMaxBytes);
+}
+
+void CWorkerPool::clearResponseCache() {
+	pResponseCache->clear();
+}
+
+std::shared_ptr<CUpstreamGroup> CWorkerPool::findUpstreamGroup(std::string_view strName) const {
+	std::lock_guard<std::mutex> lock(mutexUpstreams);
+	auto it = mapUpstreamGroups.find(strName);
+	if (it == mapUpstreamGroups.end()) {
+		throw std::invalid_argument("Unknown upstream group: " + std::string(strName));
+	}
+	return it->second;
+}
+
+void CWorkerPool::addUpstreamGroup(std::string_view strName, const std::vector<std::string>& vecEndpointURLs) {
+	addUpstreamGroup(strName, vecEndpointURLs, UpstreamGroupConfig{});
+}
+
+void CWorkerPool::addUpstreamGroup(std::string_view strName, const std::vector<std::string>& vecEndpointURLs, const UpstreamGroupConfig& config) {
+	auto pGroup = std::make_shared<CUpstreamGroup>(std::string(strName), vecEndpointURLs, config);
+	for (size_t i = 0; i < pGroup->getEndpointCount(); ++i) {
+		pGroup->getEndpoint(i).getConnectionPool().setShare(pWarmStart->getShare());
+	}
+	for (size_t i = 0; i < pGroup->getEndpointCount(); ++i) {
+		const CUpstreamEndpoint& endpoint = pGroup->getEndpoint(i);
+		if (endpoint.getUnixSocket().empty()) {
+			pDnsCache->prefetch(CUtils::extractHostName(endpoint.getURL()));
+		}
+	}
+	
+	std::lock_guard<std::mutex> lock(mutexUpstreams);
+	mapUpstreamGroups.insert_or_assign(std::string(strName), std::move(pGroup));
+}
+
+bool CWorkerPool::removeUpstreamGroup(std::string_view strName) {
+	std::lock_guard<std::mutex> lock(mutexUpstreams);
+	auto it = mapUpstreamGroups.find(strName);
+	if (it == mapUpstreamGroups.end()) {
+		return false;
+	}
+	mapUpstreamGroups.erase(it);
+	return true;
+}
+
+std::future<Response> CWorkerPool::getUpstreamAsync(std::string_view strGroup, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders) {
+	return requestUpstreamAsync("GET", strGroup, strEndpoint, vecHeaders, CRequestBody{});
+}
+
+std::future<Response> CWorkerPool::requestUpstreamAsync(std::string_view strMethod, std::string_view strGroup, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strBody) {
+	auto pGroup = findUpstreamGroup(strGroup);
+	
+	std::string strFullURL = CUtils::buildUrl(pGroup->getEndpoint(0).getURL(), strEndpoint);
+	HttpMethod eMethod = validateRequest(strMethod, strFullURL, vecHeaders, strBody.length());
+	
+	Request request({}, strEndpoint, vecHeaders, eMethod, strBody);
+	request.pUpstreamGroup = std::move(pGroup);
+	return submitRequestAsync(std::move(request));
+}
+
+std::future<Response> CWorkerPool::requestUpstreamAsync(std::string_view strMethod, std::string_view strGroup, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CRequestBody bodyRequest) {
+	return requestUpstreamAsync(strMethod, strGroup, strEndpoint, vecHeaders, std::move(bodyRequest), CCancellationToken());
+}
+
+std::future<Response> CWorkerPool::requestUpstreamAsync(std::string_view strMethod, std::string_view strGroup, std::string_view strEndpoint, const std::vector<std::pair<std::string, std::string>>& vecHeaders, CRequestBody bodyRequest, CCancellationToken tokenCancel) {
+	auto pGroup = findUpstreamGroup(strGroup);
+	
+	// every endpoint was validated when the group was added, the first one
+	// stands in for the rest when checking the full url
+	std::string strFullURL = CUtils::buildUrl(pGroup->getEndpoint(0).getURL(), strEndpoint);
+	HttpMethod eMethod = validateRequest(strMethod, strFullURL, vecHeaders, bodyRequest.isStreamed() ? 0 : bodyRequest.size());
+	
+	// cache and coalescing are keyed on the full url, which is not known until
+	// the worker picks an endpoint, so upstream requests go straight to the queue
+	Request request({}, strEndpoint, vecHeaders, eMethod, std::move(bodyRequest));
+	request.pUpstreamGroup = std::move(pGroup);
+	request.tokenCancel = std::move(tokenCancel);
+	return submitRequestAsync(std::move(request));
+}
+
+std::vector<UpstreamEndpointStats> CWorkerPool::getUpstreamStats(std::string_view strGroup) const {
+	return findUpstreamGroup(strGroup)->getStats();
+}
+
+std::vector<CircuitStats> CWorkerPool::getCircuitStats() const {
+	return pCircuitBreaker->getStats();
+}
+
+DnsCacheStats CWorkerPool::getDnsCacheStats() const {
+	return pDnsCache->getStats();
+}
+
+bool CWorkerPool::saveWarmStart() {
+	std::lock_guard<std::mutex> lock(mutexWarmStart);
+	return !strWarmStartFile.empty() && pWarmStart->save(strWarmStartFile, *pDnsCache);
+}
+
+WarmStartStats CWorkerPool::getWarmStartStats() const {
+	return pWarmStart->getStats();
+}
+
+void CWorkerPool::prefetchHost(std::string_view strHost) {
+	if (strHost.find("://") != std::string_view::npos) {
+		strHost = CUtils::extractHostName(strHost);
+	}
+	pDnsCache->prefetch(strHost);
+}
+
+size_t CWorkerPool::prewarm(std::string_view strURL, size_t iCount) {
+	if (!CUtils::isValidUrl(strURL)) {
+		throw std::invalid_argument("Invalid URL: " + std::string(strURL));
+	}
+	
+	std::string strUnixSocket = findUnixSocket(strURL);
+	std::string strHost = CConnectionPool::buildKey(CUtils::extractHost(strURL), strUnixSocket);
+	return pConnectionPool->prewarm(strHost, std::string(strURL), iCount, *pHandleProfile.load(std::memory_order_acquire), strUnixSocket);
+}
+
 size_t CWorkerPool::getPendingRequestCount() const noexcept {
 	return iPendingRequests.load(std::memory_order_relaxed);
 }
 
 size_t CWorkerPool::getActiveWorkerCount() const noexcept {
-	return vecWorkers.size();
+	std::lock_guard<std::mutex> lock(mutexWorkers);
+	return std::count_if(vecWorkers.begin(), vecWorkers.end(), [](const auto& pSlot) {
+		return !pSlot->bStopRequested.load(std::memory_order_relaxed);
+	});
+}
+
+size_t CWorkerPool::getBusyWorkerCount() const noexcept {
+	return iBusyWorkers.load(std::memory_order_relaxed);
+}
+
+size_t CWorkerPool::getIdleWorkerCount() const noexcept {
+	size_t iActive = getActiveWorkerCount();
+	return iActive - std::min(getBusyWorkerCount(), iActive);
+}
+
+size_t CWorkerPool::getOpenConnectionCount() const noexcept {
+	size_t iCount = pConnectionPool->getConnectionCount();
+	
+	std::lock_guard<std::mutex> lock(mutexUpstreams);
+	for (const auto& [strName, pGroup] : mapUpstreamGroups) {
+		for (size_t i = 0; i < pGroup->getEndpointCount(); ++i) {
+			iCount += pGroup->getEndpoint(i).getConnectionPool().getConnectionCount();
+		}
+	}
+	return iCount;
+}
+
+size_t CWorkerPool::getCoalescedRequestCount() const noexcept {
+	return pCoalescer->getCoalescedCount();
+}
+
+void CWorkerPool::setProfilingSampleRate(std::uint32_t iInterval) noexcept {
+	pProfiler->setSampleInterval(iInterval);
+}
+
+ProfilerStats CWorkerPool::getProfilerStats() const {
+	ProfilerStats stats;
+	stats.iSampleInterval = pProfiler->getSampleInterval();
+	stats.dCyclesPerNanosecond = pProfiler->getCyclesPerNanosecond();
+	stats.vecLocks.push_back(queueRequests.getLockStats("queue"));
+	stats.vecLocks.push_back(pConnectionPool->getLockStats("connection_pool"));
+	stats.vecLocks.push_back(mutexStats.getStats("stats"));
+	stats.vecStages = pProfiler->getStageStats();
+	return stats;
+}
+
+void CWorkerPool::resetProfilerStats() noexcept {
+	pProfiler->reset();
+	queueRequests.resetLockStats();
+	pConnectionPool->resetLockStats();
+	mutexStats.resetStats();
+}
+
+CacheStats CWorkerPool::getCacheStats() const {
+	return pResponseCache->getStats();
+}
+
+BufferPoolStats CWorkerPool::getBufferPoolStats() const {
+	BufferPoolStats totalStats;
+	
+	std::lock_guard<CInstrumentedMutex> lock(mutexStats);
+	for (const auto& pBufferPool : vecBufferPools) {
+		BufferPoolStats stats = pBufferPool->getStats();
+		totalStats.iHits += stats.iHits;
+		totalStats.iMisses += stats.iMisses;
+		totalStats.iRecycled += stats.iRecycled;
+		totalStats.iDropped += stats.iDropped;
+		totalStats.iPooledBytes += stats.iPooledBytes;
+	}
+	return totalStats;
 }
 
 bool CWorkerPool::isRunning() const noexcept {
@@ -405,15 +1226,33 @@ bool CWorkerPool::isRunning() const noexcept {
 }
 
 void CWorkerPool::shutdown() {
-	bShutdownFlag.store(true, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mutexMaintenance);
+		bShutdownFlag.store(true, std::memory_order_relaxed);
+	}
+	conditionMaintenance.notify_all();
 	
-	for (auto& worker : vecWorkers) {
-		if (worker.joinable()) {
-			worker.join();
+	if (threadMaintenance.joinable()) {
+		threadMaintenance.join();
+	}
+	
+	std::vector<std::unique_ptr<WorkerSlot>> vecStopped;
+	{
+		std::lock_guard<std::mutex> lock(mutexWorkers);
+		vecStopped.swap(vecWorkers);
+	}
+	
+	for (auto& pSlot : vecStopped) {
+		if (pSlot->threadWorker.joinable()) {
+			pSlot->threadWorker.join();
 		}
 	}
 	
-	vecWorkers.clear();
+	// saved once, a second shutdown from the destructor finds the path cleared
+	std::lock_guard<std::mutex> lock(mutexWarmStart);
+	if (!strWarmStartFile.empty()) {
+		pWarmStart->save(std::exchange(strWarmStartFile, std::string()), *pDnsCache);
+	}
 }
 
 void CWorkerPool::waitForCompletion() {
@@ -0,0 +1,62 @@
+#include "core/autoscaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void CWorkerAutoscaler::setConfig(const AutoscaleConfig& config) {
+	std::lock_guard<std::mutex> lock(mutexAutoscaler);
+	this->config = config;
+	bCalm = false;
+}
+
+AutoscaleConfig CWorkerAutoscaler::getConfig() const {
+	std::lock_guard<std::mutex> lock(mutexAutoscaler);
+	return config;
+}
+
+size_t CWorkerAutoscaler::evaluate(const WorkerLoadSample& sample, std::chrono::steady_clock::time_point timeNow) {
+	std::lock_guard<std::mutex> lock(mutexAutoscaler);
+	
+	size_t iWorkers = std::max<size_t>(sample.iWorkers, 1);
+	if (sample.iWorkers < config.iMinWorkers || sample.iWorkers > config.iMaxWorkers) {
+		bCalm = false;
+		return std::clamp(sample.iWorkers, config.iMinWorkers, config.iMaxWorkers);
+	}
+	
+	double dBusyRatio = static_cast<double>(sample.iBusyWorkers) / static_cast<double>(iWorkers);
+	double dQueuePerWorker = static_cast<double>(sample.iQueueDepth) / static_cast<double>(iWorkers);
+	
+	bool bBacklogged = dQueuePerWorker > config.dScaleUpQueuePerWorker;
+	bool bSaturated = sample.iQueueDepth > 0 && dBusyRatio >= config.dScaleUpBusyRatio;
+	bool bSlowQueue = config.timeQueueWaitTarget.count() > 0 && sample.timeAverageQueueWait > config.timeQueueWaitTarget;
+	
+	if (bBacklogged || bSaturated || bSlowQueue) {
+		bCalm = false;
+		
+		// enough workers to bring the backlog under the threshold, and at
+		// least a quarter more so a steep ramp is met in a few steps
+		size_t iForBacklog = static_cast<size_t>(std::ceil(static_cast<double>(sample.iQueueDepth) / std::max(config.dScaleUpQueuePerWorker, 1.0)));
+		size_t iTarget = std::max({iWorkers + std::max<size_t>(iWorkers / 4, 1), sample.iBusyWorkers + iForBacklog});
+		return std::min(iTarget, config.iMaxWorkers);
+	}
+	
+	if (sample.iQueueDepth > 0 || dBusyRatio >= config.dScaleDownBusyRatio) {
+		bCalm = false;
+		return sample.iWorkers;
+	}
+	
+	if (!bCalm) {
+		bCalm = true;
+		timeCalmSince = timeNow;
+		return sample.iWorkers;
+	}
+	if (timeNow - timeCalmSince < config.timeScaleDownDelay) {
+		return sample.iWorkers;
+	}
+	
+	// step down towards the count that would run at the scale-down ratio
+	timeCalmSince = timeNow;
+	size_t iNeeded = static_cast<size_t>(std::ceil(static_cast<double>(sample.iBusyWorkers) / std::max(config.dScaleDownBusyRatio, 0.01)));
+	size_t iStep = std::max<size_t>(std::max(iWorkers - std::min(iNeeded, iWorkers), iWorkers / 8) / 2, 1);
+	return std::max(iWorkers - std::min(iStep, iWorkers), config.iMinWorkers);
+}
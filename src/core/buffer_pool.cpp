@@ -0,0 +1,105 @@
+#include "core/buffer_pool.hpp"
+
+#include <algorithm>
+
+size_t CBufferPool::classFor(size_t iRequired) noexcept {
+	auto it = std::lower_bound(SIZE_CLASSES.begin(), SIZE_CLASSES.end(), iRequired);
+	return static_cast<size_t>(it - SIZE_CLASSES.begin());
+}
+
+void CBufferPool::reserve(std::string& strBuffer, size_t iRequired) {
+	if (iRequired <= strBuffer.capacity()) {
+		return;
+	}
+	
+	size_t iClass = classFor(iRequired);
+	if (iClass == SIZE_CLASSES.size()) {
+		iMisses.fetch_add(1, std::memory_order_relaxed);
+		strBuffer.reserve(std::max(iRequired, strBuffer.capacity() * 2));
+		return;
+	}
+	
+	std::string strReplacement;
+	{
+		std::lock_guard<std::mutex> lock(mutexPool);
+		for (size_t i = iClass; i < SIZE_CLASSES.size() && i <= iClass + 1; ++i) {
+			if (!arrFreeBuffers[i].empty()) {
+				strReplacement = std::move(arrFreeBuffers[i].back());
+				arrFreeBuffers[i].pop_back();
+				break;
+			}
+		}
+	}
+	
+	if (strReplacement.capacity() >= iRequired) {
+		iHits.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		iMisses.fetch_add(1, std::memory_order_relaxed);
+		strReplacement.reserve(SIZE_CLASSES[iClass]);
+	}
+	
+	strReplacement.assign(strBuffer);
+	release(std::move(strBuffer));
+	strBuffer = std::move(strReplacement);
+}
+
+std::vector<std::pair<std::string, std::string>> CBufferPool::acquireHeaders() {
+	std::lock_guard<std::mutex> lock(mutexPool);
+	if (vecFreeHeaders.empty()) {
+		return {};
+	}
+	
+	auto vecHeaders = std::move(vecFreeHeaders.back());
+	vecFreeHeaders.pop_back();
+	return vecHeaders;
+}
+
+void CBufferPool::release(std::string&& strBuffer) {
+	size_t iCapacity = strBuffer.capacity();
+	if (iCapacity < SIZE_CLASSES.front()) {
+		return;
+	}
+	
+	// file under the largest class the buffer can fully serve
+	auto it = std::upper_bound(SIZE_CLASSES.begin(), SIZE_CLASSES.end(), iCapacity);
+	size_t iClass = static_cast<size_t>(it - SIZE_CLASSES.begin()) - 1;
+	
+	if (iCapacity <= SIZE_CLASSES.back() * 2) {
+		std::lock_guard<std::mutex> lock(mutexPool);
+		if (arrFreeBuffers[iClass].size() < MAX_BUFFERS_PER_CLASS) {
+			strBuffer.clear();
+			arrFreeBuffers[iClass].push_back(std::move(strBuffer));
+			iRecycled.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+	
+	iDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CBufferPool::release(std::vector<std::pair<std::string, std::string>>&& vecHeaders) {
+	if (vecHeaders.capacity() == 0) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(mutexPool);
+	if (vecFreeHeaders.size() < MAX_HEADER_LISTS) {
+		vecFreeHeaders.push_back(std::move(vecHeaders));
+	}
+}
+
+BufferPoolStats CBufferPool::getStats() const {
+	BufferPoolStats stats;
+	stats.iHits = iHits.load(std::memory_order_relaxed);
+	stats.iMisses = iMisses.load(std::memory_order_relaxed);
+	stats.iRecycled = iRecycled.load(std::memory_order_relaxed);
+	stats.iDropped = iDropped.load(std::memory_order_relaxed);
+	
+	std::lock_guard<std::mutex> lock(mutexPool);
+	for (const auto& vecBuffers : arrFreeBuffers) {
+		for (const auto& strBuffer : vecBuffers) {
+			stats.iPooledBytes += strBuffer.capacity();
+		}
+	}
+	return stats;
+}
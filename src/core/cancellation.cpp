@@ -0,0 +1,42 @@
+#include "core/cancellation.hpp"
+
+#include <algorithm>
+
+CCancellationToken CCancellationToken::create() {
+	CCancellationToken token;
+	token.pState = std::make_shared<State>();
+	return token;
+}
+
+void CCancellationToken::cancel() const {
+	if (!pState || pState->bCancelled.exchange(true, std::memory_order_acq_rel)) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(pState->mutexWakers);
+	for (CURLM* pMulti : pState->vecWakers) {
+		curl_multi_wakeup(pMulti);
+	}
+}
+
+void CCancellationToken::attachWaker(CURLM* pMulti) const {
+	if (!pState) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(pState->mutexWakers);
+	pState->vecWakers.push_back(pMulti);
+}
+
+void CCancellationToken::detachWaker(CURLM* pMulti) const {
+	if (!pState) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(pState->mutexWakers);
+	auto it = std::find(pState->vecWakers.begin(), pState->vecWakers.end(), pMulti);
+	if (it != pState->vecWakers.end()) {
+		*it = pState->vecWakers.back();
+		pState->vecWakers.pop_back();
+	}
+}
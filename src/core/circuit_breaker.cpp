@@ -0,0 +1,176 @@
+#include "core/circuit_breaker.hpp"
+
+void CCircuitBreaker::setConfig(const CircuitBreakerConfig& config) {
+	std::lock_guard<std::mutex> lock(mutexCircuits);
+	this->config = config;
+}
+
+bool CCircuitBreaker::isFailure(const Response& response) noexcept {
+	switch (response.eError) {
+		case ResponseError::Timeout:
+		case ResponseError::ConnectFailed:
+		case ResponseError::TlsFailed:
+		case ResponseError::TransportFailed:
+			return true;
+		default:
+			break;
+	}
+	return response.iStatusCode == 502 || response.iStatusCode == 503 || response.iStatusCode == 504;
+}
+
+CCircuitBreaker::Circuit& CCircuitBreaker::findCircuit(std::string_view strHost, CircuitBreakerConfig& configOut) {
+	std::lock_guard<std::mutex> lock(mutexCircuits);
+	configOut = config;
+	
+	auto it = mapCircuits.find(strHost);
+	if (it == mapCircuits.end()) {
+		auto pCircuit = std::make_unique<Circuit>();
+		pCircuit->timeWindowStart = pCircuit->timeLastChange = std::chrono::steady_clock::now();
+		it = mapCircuits.emplace(std::string(strHost), std::move(pCircuit)).first;
+	}
+	return *it->second;
+}
+
+CCircuitBreaker::Circuit* CCircuitBreaker::findExisting(std::string_view strHost, CircuitBreakerConfig& configOut) {
+	std::lock_guard<std::mutex> lock(mutexCircuits);
+	configOut = config;
+	
+	auto it = mapCircuits.find(strHost);
+	return it == mapCircuits.end() ? nullptr : it->second.get();
+}
+
+void CCircuitBreaker::trip(Circuit& circuit, std::chrono::steady_clock::time_point timeNow) {
+	circuit.eState = CircuitState::Open;
+	circuit.timeLastChange = timeNow;
+	circuit.iConsecutiveFailures = 0;
+	circuit.iWindowRequests = 0;
+	circuit.iWindowFailures = 0;
+	circuit.iProbeSuccesses = 0;
+	++circuit.iTrips;
+}
+
+CCircuitBreaker::Admission CCircuitBreaker::tryAcquire(std::string_view strHost) {
+	CircuitBreakerConfig configCurrent;
+	Circuit& circuit = findCircuit(strHost, configCurrent);
+	
+	std::lock_guard<std::mutex> lock(circuit.mutexCircuit);
+	auto timeNow = std::chrono::steady_clock::now();
+	
+	if (circuit.eState == CircuitState::Open) {
+		if (timeNow - circuit.timeLastChange < configCurrent.timeOpen) {
+			++circuit.iRejected;
+			return Admission::Rejected;
+		}
+		circuit.eState = CircuitState::HalfOpen;
+		circuit.timeLastChange = timeNow;
+		circuit.iProbesInFlight = 0;
+		circuit.iProbeSuccesses = 0;
+	}
+	
+	if (circuit.eState == CircuitState::HalfOpen) {
+		if (circuit.iProbesInFlight + circuit.iProbeSuccesses >= configCurrent.iHalfOpenProbes) {
+			++circuit.iRejected;
+			return Admission::Rejected;
+		}
+		++circuit.iProbesInFlight;
+		return Admission::Probe;
+	}
+	
+	return Admission::Allowed;
+}
+
+void CCircuitBreaker::record(std::string_view strHost, Admission eAdmission, bool bFailure) {
+	if (eAdmission == Admission::Rejected) {
+		return;
+	}
+	
+	CircuitBreakerConfig configCurrent;
+	Circuit& circuit = findCircuit(strHost, configCurrent);
+	
+	std::lock_guard<std::mutex> lock(circuit.mutexCircuit);
+	auto timeNow = std::chrono::steady_clock::now();
+	
+	if (eAdmission == Admission::Probe) {
+		if (circuit.iProbesInFlight > 0) {
+			--circuit.iProbesInFlight;
+		}
+		// another probe may already have decided the outcome
+		if (circuit.eState != CircuitState::HalfOpen) {
+			return;
+		}
+		
+		if (bFailure) {
+			trip(circuit, timeNow);
+		} else if (++circuit.iProbeSuccesses >= configCurrent.iHalfOpenProbes) {
+			circuit.eState = CircuitState::Closed;
+			circuit.timeLastChange = timeNow;
+			circuit.timeWindowStart = timeNow;
+			circuit.iProbeSuccesses = 0;
+			++circuit.iRecoveries;
+		}
+		return;
+	}
+	
+	// requests admitted before the circuit tripped say nothing new
+	if (circuit.eState != CircuitState::Closed) {
+		return;
+	}
+	
+	if (timeNow - circuit.timeWindowStart >= configCurrent.timeWindow) {
+		circuit.timeWindowStart = timeNow;
+		circuit.iWindowRequests = 0;
+		circuit.iWindowFailures = 0;
+	}
+	
+	++circuit.iWindowRequests;
+	if (!bFailure) {
+		circuit.iConsecutiveFailures = 0;
+		return;
+	}
+	++circuit.iWindowFailures;
+	++circuit.iConsecutiveFailures;
+	
+	bool bConsecutiveTrip = configCurrent.iConsecutiveFailures > 0 && circuit.iConsecutiveFailures >= configCurrent.iConsecutiveFailures;
+	bool bRateTrip = configCurrent.iMinimumRequests > 0 && circuit.iWindowRequests >= configCurrent.iMinimumRequests && 
+	                 static_cast<double>(circuit.iWindowFailures) >= configCurrent.dFailureRate * static_cast<double>(circuit.iWindowRequests);
+	if (bConsecutiveTrip || bRateTrip) {
+		trip(circuit, timeNow);
+	}
+}
+
+bool CCircuitBreaker::rejectIfOpen(std::string_view strHost) {
+	CircuitBreakerConfig configCurrent;
+	Circuit* pCircuit = findExisting(strHost, configCurrent);
+	if (!pCircuit) {
+		return false;
+	}
+	
+	std::lock_guard<std::mutex> lock(pCircuit->mutexCircuit);
+	if (pCircuit->eState != CircuitState::Open || std::chrono::steady_clock::now() - pCircuit->timeLastChange >= configCurrent.timeOpen) {
+		return false;
+	}
+	++pCircuit->iRejected;
+	return true;
+}
+
+std::vector<CircuitStats> CCircuitBreaker::getStats() const {
+	std::lock_guard<std::mutex> lock(mutexCircuits);
+	
+	std::vector<CircuitStats> vecStats;
+	vecStats.reserve(mapCircuits.size());
+	for (const auto& [strHost, pCircuit] : mapCircuits) {
+		std::lock_guard<std::mutex> lockCircuit(pCircuit->mutexCircuit);
+		
+		CircuitStats stats;
+		stats.strHost = strHost;
+		stats.eState = pCircuit->eState;
+		stats.iWindowRequests = pCircuit->iWindowRequests;
+		stats.iWindowFailures = pCircuit->iWindowFailures;
+		stats.iRejected = pCircuit->iRejected;
+		stats.iTrips = pCircuit->iTrips;
+		stats.iRecoveries = pCircuit->iRecoveries;
+		stats.timeLastChange = pCircuit->timeLastChange;
+		vecStats.push_back(std::move(stats));
+	}
+	return vecStats;
+}
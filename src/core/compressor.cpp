@@ -0,0 +1,37 @@
+#include "core/compressor.hpp"
+
+// 15 window bits plus 16 selects the gzip wrapper instead of raw zlib
+static constexpr int GZIP_WINDOW_BITS = 15 + 16;
+static constexpr int DEFLATE_MEM_LEVEL = 8;
+
+CGzipCompressor::CGzipCompressor(int iLevel) {
+	bInitialized = deflateInit2(&streamDeflate, iLevel, Z_DEFLATED, GZIP_WINDOW_BITS, DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+CGzipCompressor::~CGzipCompressor() {
+	if (bInitialized) {
+		deflateEnd(&streamDeflate);
+	}
+}
+
+std::string_view CGzipCompressor::compress(std::string_view strInput) {
+	if (!bInitialized || deflateReset(&streamDeflate) != Z_OK) {
+		return {};
+	}
+	
+	size_t iBound = deflateBound(&streamDeflate, static_cast<uLong>(strInput.size()));
+	if (strOutput.size() < iBound) {
+		strOutput.resize(iBound);
+	}
+	
+	streamDeflate.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(strInput.data()));
+	streamDeflate.avail_in = static_cast<uInt>(strInput.size());
+	streamDeflate.next_out = reinterpret_cast<Bytef*>(strOutput.data());
+	streamDeflate.avail_out = static_cast<uInt>(strOutput.size());
+	
+	if (deflate(&streamDeflate, Z_FINISH) != Z_STREAM_END) {
+		return {};
+	}
+	
+	return std::string_view(strOutput.data(), streamDeflate.total_out);
+}
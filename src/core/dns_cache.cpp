@@ -0,0 +1,381 @@
+#include "core/dns_cache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+static std::string joinAddresses(const std::vector<std::string>& vecAddresses) {
+	std::string strJoined;
+	for (const auto& strAddress : vecAddresses) {
+		if (!strJoined.empty()) {
+			strJoined += ',';
+		}
+		// curl wants ipv6 addresses bracketed in a resolve entry
+		if (strAddress.find(':') != std::string::npos) {
+			strJoined.append(1, '[').append(strAddress).append(1, ']');
+		} else {
+			strJoined += strAddress;
+		}
+	}
+	return strJoined;
+}
+
+CDnsCache::~CDnsCache() {
+	{
+		std::lock_guard<std::mutex> lock(mutexLookups);
+		bStopping = true;
+	}
+	conditionLookups.notify_all();
+	
+	for (auto& threadResolver : vecResolvers) {
+		threadResolver.join();
+	}
+}
+
+std::int64_t CDnsCache::ticks(Clock::time_point timePoint) noexcept {
+	return timePoint.time_since_epoch().count();
+}
+
+bool CDnsCache::isAddressLiteral(std::string_view strHost) noexcept {
+	char arrHost[INET6_ADDRSTRLEN + 1];
+	if (strHost.empty() || strHost.size() > INET6_ADDRSTRLEN) {
+		return false;
+	}
+	strHost.copy(arrHost, strHost.size());
+	arrHost[strHost.size()] = '\0';
+	
+	unsigned char arrAddress[sizeof(in6_addr)];
+	return inet_pton(AF_INET, arrHost, arrAddress) == 1 || inet_pton(AF_INET6, arrHost, arrAddress) == 1;
+}
+
+void CDnsCache::setConfig(const DnsCacheConfig& config) {
+	if (config.timeTTL.count() <= 0 || config.dRefreshAhead <= 0.0 || config.dRefreshAhead > 1.0 || config.iResolverThreads == 0) {
+		throw std::invalid_argument("Invalid DNS cache configuration");
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(mutexEntries);
+	this->config = config;
+}
+
+void CDnsCache::prefetch(std::string_view strHost) {
+	if (!bEnabled.load(std::memory_order_relaxed) || strHost.empty() || isAddressLiteral(strHost)) {
+		return;
+	}
+	
+	{
+		std::shared_lock<std::shared_mutex> lock(mutexEntries);
+		if (mapEntries.find(strHost) != mapEntries.end()) {
+			return;
+		}
+	}
+	enqueue(strHost, false);
+}
+
+bool CDnsCache::find(std::string_view strHost, std::string* pJoined, std::vector<std::string>* pAddresses) {
+	if (strHost.empty() || isAddressLiteral(strHost)) {
+		return false;
+	}
+	
+	auto timeNow = Clock::now();
+	bool bRefresh = false;
+	{
+		std::shared_lock<std::shared_mutex> lock(mutexEntries);
+		auto it = mapEntries.find(strHost);
+		if (it != mapEntries.end()) {
+			const Entry& entry = it->second;
+			
+			// an expired entry is still served while its refresh is in flight
+			if (!entry.vecAddresses.empty() && (entry.bStatic || entry.bPending || timeNow < entry.timeExpires)) {
+				if (pJoined) {
+					*pJoined = entry.strJoined;
+				}
+				if (pAddresses) {
+					*pAddresses = entry.vecAddresses;
+				}
+				it->second.iLastUsed.store(ticks(timeNow), std::memory_order_relaxed);
+				iHits.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			
+			if (entry.bPending || (entry.bFailed && timeNow < entry.timeExpires)) {
+				iMisses.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			bRefresh = true;
+		}
+	}
+	
+	iMisses.fetch_add(1, std::memory_order_relaxed);
+	if (bEnabled.load(std::memory_order_relaxed)) {
+		enqueue(strHost, bRefresh);
+	}
+	return false;
+}
+
+bool CDnsCache::lookup(std::string_view strHost, std::vector<std::string>& vecAddresses) {
+	return find(strHost, nullptr, &vecAddresses);
+}
+
+std::string CDnsCache::formatResolveEntry(std::string_view strHost, std::uint16_t iPort) {
+	std::string strJoined;
+	if (iPort == 0 || !find(strHost, &strJoined, nullptr)) {
+		return {};
+	}
+	
+	std::string strEntry;
+	strEntry.reserve(strHost.size() + strJoined.size() + 8);
+	strEntry.append(strHost).append(1, ':').append(std::to_string(iPort)).append(1, ':').append(strJoined);
+	return strEntry;
+}
+
+void CDnsCache::enqueue(std::string_view strHost, bool bRefresh) {
+	{
+		std::unique_lock<std::shared_mutex> lock(mutexEntries);
+		auto [it, bInserted] = mapEntries.try_emplace(std::string(strHost));
+		if (!bInserted && (it->second.bPending || it->second.bStatic)) {
+			return;
+		}
+		it->second.bPending = true;
+	}
+	pushLookup(std::string(strHost), bRefresh);
+}
+
+void CDnsCache::pushLookup(std::string strHost, bool bRefresh) {
+	{
+		std::lock_guard<std::mutex> lock(mutexLookups);
+		if (bStopping) {
+			return;
+		}
+		
+		if (vecResolvers.empty()) {
+			size_t iThreads;
+			{
+				std::shared_lock<std::shared_mutex> lockEntries(mutexEntries);
+				iThreads = config.iResolverThreads;
+			}
+			for (size_t i = 0; i < iThreads; ++i) {
+				vecResolvers.emplace_back(&CDnsCache::resolverLoop, this);
+			}
+		}
+		
+		queueLookups.emplace_back(std::move(strHost), bRefresh);
+	}
+	conditionLookups.notify_one();
+}
+
+void CDnsCache::resolverLoop() {
+	while (true) {
+		std::pair<std::string, bool> lookupNext;
+		{
+			std::unique_lock<std::mutex> lock(mutexLookups);
+			conditionLookups.wait(lock, [this] { return bStopping || !queueLookups.empty(); });
+			if (bStopping) {
+				return;
+			}
+			lookupNext = std::move(queueLookups.front());
+			queueLookups.pop_front();
+		}
+		resolve(lookupNext.first, lookupNext.second);
+	}
+}
+
+void CDnsCache::resolve(const std::string& strHost, bool bRefresh) {
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	
+	std::vector<std::string> vecAddresses;
+	addrinfo* pAddresses = nullptr;
+	if (getaddrinfo(strHost.c_str(), nullptr, &hints, &pAddresses) == 0) {
+		for (addrinfo* pAddress = pAddresses; pAddress; pAddress = pAddress->ai_next) {
+			char arrAddress[INET6_ADDRSTRLEN];
+			const void* pRaw = pAddress->ai_family == AF_INET6 
+				? static_cast<const void*>(&reinterpret_cast<sockaddr_in6*>(pAddress->ai_addr)->sin6_addr) 
+				: static_cast<const void*>(&reinterpret_cast<sockaddr_in*>(pAddress->ai_addr)->sin_addr);
+			if (inet_ntop(pAddress->ai_family, pRaw, arrAddress, sizeof(arrAddress)) && 
+			    std::find(vecAddresses.begin(), vecAddresses.end(), arrAddress) == vecAddresses.end()) {
+				vecAddresses.emplace_back(arrAddress);
+			}
+		}
+		freeaddrinfo(pAddresses);
+	}
+	
+	iLookups.fetch_add(1, std::memory_order_relaxed);
+	if (bRefresh) {
+		iRefreshes.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(mutexEntries);
+	Entry& entry = mapEntries.try_emplace(strHost).first->second;
+	entry.bPending = false;
+	
+	// an override set while we were resolving wins
+	if (entry.bStatic) {
+		return;
+	}
+	
+	auto timeNow = Clock::now();
+	if (vecAddresses.empty()) {
+		iFailures.fetch_add(1, std::memory_order_relaxed);
+		
+		// a failed refresh keeps the old addresses until they expire
+		entry.timeResolved = timeNow;
+		if (entry.vecAddresses.empty() || timeNow >= entry.timeExpires) {
+			entry.vecAddresses.clear();
+			entry.strJoined.clear();
+			entry.bFailed = true;
+			entry.timeExpires = timeNow + config.timeNegativeTTL;
+		}
+		return;
+	}
+	
+	entry.strJoined = joinAddresses(vecAddresses);
+	entry.vecAddresses = std::move(vecAddresses);
+	entry.timeResolved = timeNow;
+	entry.timeExpires = timeNow + config.timeTTL;
+	entry.bFailed = false;
+}
+
+void CDnsCache::setOverride(std::string_view strHost, const std::vector<std::string>& vecAddresses) {
+	for (const auto& strAddress : vecAddresses) {
+		if (!isAddressLiteral(strAddress)) {
+			throw std::invalid_argument("DNS override needs IP addresses, got: " + strAddress);
+		}
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(mutexEntries);
+	if (vecAddresses.empty()) {
+		auto it = mapEntries.find(strHost);
+		if (it == mapEntries.end() || !it->second.bStatic) {
+			return;
+		}
+		iOverrides.fetch_sub(1, std::memory_order_relaxed);
+		if (it->second.bPending) {
+			it->second.bStatic = false;
+			it->second.timeExpires = Clock::now();
+		} else {
+			mapEntries.erase(it);
+		}
+		return;
+	}
+	
+	Entry& entry = mapEntries.try_emplace(std::string(strHost)).first->second;
+	if (!entry.bStatic) {
+		iOverrides.fetch_add(1, std::memory_order_relaxed);
+	}
+	entry.vecAddresses = vecAddresses;
+	entry.strJoined = joinAddresses(vecAddresses);
+	entry.bStatic = true;
+	entry.bFailed = false;
+}
+
+void CDnsCache::refreshExpiring() {
+	if (!bEnabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+	
+	auto timeNow = Clock::now();
+	std::vector<std::string> vecRefresh;
+	
+	{
+		std::unique_lock<std::shared_mutex> lock(mutexEntries);
+		auto timeRefreshAfter = std::chrono::duration_cast<Clock::duration>(config.timeTTL * config.dRefreshAhead);
+		
+		for (auto it = mapEntries.begin(); it != mapEntries.end();) {
+			Entry& entry = it->second;
+			if (entry.bStatic || entry.bPending) {
+				++it;
+				continue;
+			}
+			
+			bool bUsed = entry.iLastUsed.load(std::memory_order_relaxed) > ticks(entry.timeResolved);
+			if (!entry.bFailed && bUsed && timeNow - entry.timeResolved >= timeRefreshAfter) {
+				entry.bPending = true;
+				vecRefresh.push_back(it->first);
+				++it;
+			} else if (timeNow >= entry.timeExpires) {
+				it = mapEntries.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	
+	for (auto& strHost : vecRefresh) {
+		pushLookup(std::move(strHost), true);
+	}
+}
+
+std::vector<DnsSnapshotEntry> CDnsCache::exportEntries() const {
+	auto timeNow = Clock::now();
+	auto timeWallNow = std::chrono::system_clock::now();
+	std::vector<DnsSnapshotEntry> vecSnapshot;
+	
+	std::shared_lock<std::shared_mutex> lock(mutexEntries);
+	vecSnapshot.reserve(mapEntries.size());
+	for (const auto& [strHost, entry] : mapEntries) {
+		if (entry.bStatic || entry.bFailed || entry.vecAddresses.empty() || timeNow >= entry.timeExpires) {
+			continue;
+		}
+		auto timeRemaining = std::chrono::duration_cast<std::chrono::system_clock::duration>(entry.timeExpires - timeNow);
+		vecSnapshot.push_back(DnsSnapshotEntry{strHost, entry.vecAddresses, timeWallNow + timeRemaining});
+	}
+	return vecSnapshot;
+}
+
+size_t CDnsCache::importEntries(const std::vector<DnsSnapshotEntry>& vecSnapshot) {
+	auto timeNow = Clock::now();
+	auto timeWallNow = std::chrono::system_clock::now();
+	size_t iImported = 0;
+	
+	std::unique_lock<std::shared_mutex> lock(mutexEntries);
+	for (const auto& snapshotEntry : vecSnapshot) {
+		if (snapshotEntry.timeExpires <= timeWallNow || snapshotEntry.vecAddresses.empty() || 
+		    !std::all_of(snapshotEntry.vecAddresses.begin(), snapshotEntry.vecAddresses.end(), [](const std::string& strAddress) { return isAddressLiteral(strAddress); })) {
+			continue;
+		}
+		
+		auto [it, bInserted] = mapEntries.try_emplace(snapshotEntry.strHost);
+		if (!bInserted) {
+			continue;
+		}
+		
+		// backdate the lookup so the refresh-ahead point keeps its place in the ttl
+		auto timeRemaining = std::min(std::chrono::duration_cast<Clock::duration>(snapshotEntry.timeExpires - timeWallNow), 
+		                              std::chrono::duration_cast<Clock::duration>(config.timeTTL));
+		Entry& entry = it->second;
+		entry.vecAddresses = snapshotEntry.vecAddresses;
+		entry.strJoined = joinAddresses(entry.vecAddresses);
+		entry.timeExpires = timeNow + timeRemaining;
+		entry.timeResolved = entry.timeExpires - std::chrono::duration_cast<Clock::duration>(config.timeTTL);
+		++iImported;
+	}
+	return iImported;
+}
+
+void CDnsCache::clear() {
+	std::unique_lock<std::shared_mutex> lock(mutexEntries);
+	for (auto it = mapEntries.begin(); it != mapEntries.end();) {
+		if (it->second.bStatic || it->second.bPending) {
+			++it;
+		} else {
+			it = mapEntries.erase(it);
+		}
+	}
+}
+
+DnsCacheStats CDnsCache::getStats() const {
+	DnsCacheStats stats;
+	stats.iHits = iHits.load(std::memory_order_relaxed);
+	stats.iMisses = iMisses.load(std::memory_order_relaxed);
+	stats.iLookups = iLookups.load(std::memory_order_relaxed);
+	stats.iRefreshes = iRefreshes.load(std::memory_order_relaxed);
+	stats.iFailures = iFailures.load(std::memory_order_relaxed);
+	
+	std::shared_lock<std::shared_mutex> lock(mutexEntries);
+	stats.iEntries = mapEntries.size();
+	return stats;
+}
@@ -0,0 +1,162 @@
+#include "core/handle_profile.hpp"
+
+std::atomic<std::uint64_t> CHandleProfile::iNextId{1};
+
+CHandleState::Shape CHandleState::shapeOf(HttpMethod eMethod, bool bStreamBody) noexcept {
+	switch (eMethod) {
+		case HttpMethod::Get: return Shape::Get;
+		case HttpMethod::Head: return Shape::Head;
+		case HttpMethod::Delete: return Shape::Delete;
+		case HttpMethod::Options: return Shape::Options;
+		case HttpMethod::Post: return bStreamBody ? Shape::PostStreamed : Shape::PostBuffered;
+		case HttpMethod::Put: return bStreamBody ? Shape::PutStreamed : Shape::PutBuffered;
+	}
+	return Shape::Get;
+}
+
+void CHandleState::setMethod(CURL* pHandle, HttpMethod eMethod, bool bStreamBody) {
+	Shape eNext = shapeOf(eMethod, bStreamBody);
+	if (eNext == eShape) {
+		return;
+	}
+	
+	// undo the previous shape back to what a reset leaves, a plain GET
+	switch (eShape) {
+		case Shape::Get:
+			break;
+		case Shape::Head:
+			curl_easy_setopt(pHandle, CURLOPT_NOBODY, 0L);
+			break;
+		case Shape::Delete:
+		case Shape::Options:
+			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, nullptr);
+			break;
+		case Shape::PostBuffered:
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, nullptr);
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, -1L);
+			break;
+		case Shape::PostStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_READDATA, nullptr);
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(-1));
+			break;
+		case Shape::PutBuffered:
+			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, nullptr);
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, nullptr);
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, -1L);
+			break;
+		case Shape::PutStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_UPLOAD, 0L);
+			curl_easy_setopt(pHandle, CURLOPT_READDATA, nullptr);
+			curl_easy_setopt(pHandle, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(-1));
+			break;
+	}
+	if (eShape != Shape::Get) {
+		curl_easy_setopt(pHandle, CURLOPT_HTTPGET, 1L);
+	}
+	
+	switch (eNext) {
+		case Shape::Get:
+			break;
+		case Shape::Head:
+			curl_easy_setopt(pHandle, CURLOPT_NOBODY, 1L);
+			break;
+		case Shape::Delete:
+			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "DELETE");
+			break;
+		case Shape::Options:
+			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "OPTIONS");
+			break;
+		case Shape::PostBuffered:
+		case Shape::PostStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_POST, 1L);
+			break;
+		case Shape::PutBuffered:
+			curl_easy_setopt(pHandle, CURLOPT_CUSTOMREQUEST, "PUT");
+			break;
+		case Shape::PutStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_UPLOAD, 1L);
+			break;
+	}
+	eShape = eNext;
+}
+
+void CHandleState::setBody(CURL* pHandle, std::string_view strBody, void* pReadData, curl_off_t iStreamSize) {
+	switch (eShape) {
+		case Shape::PostBuffered:
+		case Shape::PutBuffered:
+			// a null pointer would make curl read the body through the callback
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDS, strBody.empty() ? "" : strBody.data());
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE, static_cast<long>(strBody.length()));
+			break;
+		case Shape::PostStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_READDATA, pReadData);
+			curl_easy_setopt(pHandle, CURLOPT_POSTFIELDSIZE_LARGE, iStreamSize);
+			break;
+		case Shape::PutStreamed:
+			curl_easy_setopt(pHandle, CURLOPT_READDATA, pReadData);
+			curl_easy_setopt(pHandle, CURLOPT_INFILESIZE_LARGE, iStreamSize);
+			break;
+		default:
+			break;
+	}
+}
+
+void CHandleState::setHeaders(CURL* pHandle, curl_slist* pHeaders) {
+	if (pHeaders || bHeaders) {
+		curl_easy_setopt(pHandle, CURLOPT_HTTPHEADER, pHeaders);
+		bHeaders = pHeaders != nullptr;
+	}
+}
+
+void CHandleState::setResolve(CURL* pHandle, curl_slist* pResolve) {
+	if (pResolve || bResolve) {
+		curl_easy_setopt(pHandle, CURLOPT_RESOLVE, pResolve);
+		bResolve = pResolve != nullptr;
+	}
+}
+
+void CHandleState::setUnixSocket(CURL* pHandle, std::string_view strUnixSocket) {
+	if (strUnixSocket == this->strUnixSocket) {
+		return;
+	}
+	
+	// both options share one path, clearing either drops the socket
+	if (strUnixSocket.empty()) {
+		curl_easy_setopt(pHandle, CURLOPT_UNIX_SOCKET_PATH, nullptr);
+	} else {
+		bool bAbstract = strUnixSocket.front() == '@';
+		std::string strPath(bAbstract ? strUnixSocket.substr(1) : strUnixSocket);
+		curl_easy_setopt(pHandle, bAbstract ? CURLOPT_ABSTRACT_UNIX_SOCKET : CURLOPT_UNIX_SOCKET_PATH, strPath.c_str());
+	}
+	this->strUnixSocket = strUnixSocket;
+}
+
+CHandleProfile::CHandleProfile(const Settings& settings) : iId(iNextId.fetch_add(1, std::memory_order_relaxed)), settings(settings) {}
+
+bool CHandleProfile::bind(CURL* pHandle, CHandleState& state) const {
+	bool bReset = state.iProfile != iId || state.bBusy;
+	if (bReset) {
+		// the share and the open connections survive a reset
+		curl_easy_reset(pHandle);
+		state = CHandleState();
+		
+		curl_easy_setopt(pHandle, CURLOPT_WRITEFUNCTION, settings.fnWrite);
+		curl_easy_setopt(pHandle, CURLOPT_HEADERFUNCTION, settings.fnHeader);
+		curl_easy_setopt(pHandle, CURLOPT_READFUNCTION, settings.fnRead);
+		curl_easy_setopt(pHandle, CURLOPT_TIMEOUT_MS, static_cast<long>(settings.timeTimeout.count()));
+		curl_easy_setopt(pHandle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(settings.timeConnectTimeout.count()));
+		curl_easy_setopt(pHandle, CURLOPT_TCP_NODELAY, 1L);
+		curl_easy_setopt(pHandle, CURLOPT_TCP_FASTOPEN, 1L);
+		curl_easy_setopt(pHandle, CURLOPT_FOLLOWLOCATION, 1L);
+		curl_easy_setopt(pHandle, CURLOPT_MAXREDIRS, 3L);
+		curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYPEER, 0L);
+		curl_easy_setopt(pHandle, CURLOPT_SSL_VERIFYHOST, 0L);
+		curl_easy_setopt(pHandle, CURLOPT_USERAGENT, USER_AGENT);
+		if (settings.bAcceptEncoding) {
+			curl_easy_setopt(pHandle, CURLOPT_ACCEPT_ENCODING, "");
+		}
+		state.iProfile = iId;
+	}
+	state.bBusy = true;
+	return bReset;
+}
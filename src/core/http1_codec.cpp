@@ -0,0 +1,257 @@
+#include "core/http1_codec.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include <strings.h>
+
+static std::string_view trimWhitespace(std::string_view strInput) noexcept {
+	size_t iStart = strInput.find_first_not_of(" \t");
+	if (iStart == std::string_view::npos) {
+		return {};
+	}
+	return strInput.substr(iStart, strInput.find_last_not_of(" \t") - iStart + 1);
+}
+
+static bool equalsIgnoreCase(std::string_view strLeft, std::string_view strRight) noexcept {
+	return strLeft.size() == strRight.size() && strncasecmp(strLeft.data(), strRight.data(), strLeft.size()) == 0;
+}
+
+static bool containsToken(std::string_view strList, std::string_view strToken) noexcept {
+	while (!strList.empty()) {
+		size_t iComma = strList.find(',');
+		if (equalsIgnoreCase(trimWhitespace(strList.substr(0, iComma)), strToken)) {
+			return true;
+		}
+		strList = iComma == std::string_view::npos ? std::string_view{} : strList.substr(iComma + 1);
+	}
+	return false;
+}
+
+void CHttp1Serializer::writeRequestHead(std::string& strHead, HttpMethod eMethod, std::string_view strTarget, std::string_view strHostHeader, const std::vector<std::pair<std::string, std::string>>& vecHeaders, size_t iBodySize) {
+	strHead.clear();
+	strHead.append(CUtils::httpMethodName(eMethod)).append(1, ' ').append(strTarget).append(" HTTP/1.1\r\n");
+	
+	bool bHasHost = false;
+	bool bHasUserAgent = false;
+	bool bHasAccept = false;
+	for (const auto& header : vecHeaders) {
+		bHasHost = bHasHost || equalsIgnoreCase(header.first, "Host");
+		bHasUserAgent = bHasUserAgent || equalsIgnoreCase(header.first, "User-Agent");
+		bHasAccept = bHasAccept || equalsIgnoreCase(header.first, "Accept");
+	}
+	
+	if (!bHasHost) {
+		strHead.append("Host: ").append(strHostHeader).append("\r\n");
+	}
+	if (!bHasUserAgent) {
+		strHead.append("User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n");
+	}
+	if (!bHasAccept) {
+		strHead.append("Accept: */*\r\n");
+	}
+	
+	for (const auto& header : vecHeaders) {
+		strHead.append(header.first).append(": ").append(header.second).append("\r\n");
+	}
+	
+	if (iBodySize > 0 || eMethod == HttpMethod::Post || eMethod == HttpMethod::Put) {
+		char arrDigits[24];
+		auto result = std::to_chars(arrDigits, arrDigits + sizeof(arrDigits), iBodySize);
+		strHead.append("Content-Length: ").append(arrDigits, result.ptr).append("\r\n");
+	}
+	
+	strHead.append("\r\n");
+}
+
+void CHttp1ResponseParser::reset(Response* pResponse, CBufferPool* pBufferPool, bool bNoBody) noexcept {
+	this->pResponse = pResponse;
+	this->pBufferPool = pBufferPool;
+	this->bNoBody = bNoBody;
+	eState = State::StatusLine;
+	strLine.clear();
+	iRemaining = 0;
+	iContentLength = -1;
+	bChunked = false;
+	bKeepAlive = true;
+	bStarted = false;
+}
+
+size_t CHttp1ResponseParser::feed(const char* pData, size_t iLength) {
+	size_t iConsumed = 0;
+	if (iLength > 0) {
+		bStarted = true;
+	}
+	
+	while (iConsumed < iLength && eState != State::Done && eState != State::Error) {
+		const char* pCursor = pData + iConsumed;
+		size_t iAvailable = iLength - iConsumed;
+		
+		switch (eState) {
+			case State::Body:
+			case State::ChunkData: {
+				size_t iTake = static_cast<size_t>(std::min<std::uint64_t>(iRemaining, iAvailable));
+				appendBody(pCursor, iTake);
+				iConsumed += iTake;
+				iRemaining -= iTake;
+				if (iRemaining == 0) {
+					eState = eState == State::Body ? State::Done : State::ChunkDataEnd;
+				}
+				break;
+			}
+			case State::UntilClose:
+				appendBody(pCursor, iAvailable);
+				iConsumed += iAvailable;
+				break;
+			default: {
+				const char* pNewline = static_cast<const char*>(std::memchr(pCursor, '\n', iAvailable));
+				size_t iTake = pNewline ? static_cast<size_t>(pNewline - pCursor) + 1 : iAvailable;
+				
+				if (strLine.size() + iTake > MAX_LINE_LENGTH) {
+					eState = State::Error;
+					break;
+				}
+				iConsumed += iTake;
+				
+				if (!pNewline) {
+					strLine.append(pCursor, iTake);
+					break;
+				}
+				
+				// complete lines inside one buffer are parsed in place
+				std::string_view strComplete;
+				if (strLine.empty()) {
+					strComplete = std::string_view(pCursor, iTake - 1);
+				} else {
+					strLine.append(pCursor, iTake - 1);
+					strComplete = strLine;
+				}
+				if (!strComplete.empty() && strComplete.back() == '\r') {
+					strComplete.remove_suffix(1);
+				}
+				
+				onLine(strComplete);
+				strLine.clear();
+				break;
+			}
+		}
+	}
+	
+	return iConsumed;
+}
+
+void CHttp1ResponseParser::onLine(std::string_view strLine) {
+	switch (eState) {
+		case State::StatusLine: {
+			// "HTTP/1.1 200 OK"
+			if (strLine.size() < 12 || strLine.substr(0, 5) != "HTTP/") {
+				eState = State::Error;
+				return;
+			}
+			unsigned int iStatusCode = 0;
+			auto result = std::from_chars(strLine.data() + 9, strLine.data() + 12, iStatusCode);
+			if (result.ec != std::errc{}) {
+				eState = State::Error;
+				return;
+			}
+			pResponse->iStatusCode = iStatusCode;
+			bKeepAlive = strLine.substr(5, 3) != "1.0";
+			eState = State::Headers;
+			return;
+		}
+		case State::Headers: {
+			if (strLine.empty()) {
+				onHeadersComplete();
+				return;
+			}
+			
+			size_t iColonPos = strLine.find(':');
+			if (iColonPos == std::string_view::npos) {
+				return;
+			}
+			std::string_view strKey = trimWhitespace(strLine.substr(0, iColonPos));
+			std::string_view strValue = trimWhitespace(strLine.substr(iColonPos + 1));
+			pResponse->vecHeaders.emplace_back(strKey, strValue);
+			
+			if (equalsIgnoreCase(strKey, "Content-Length")) {
+				std::int64_t iLength = -1;
+				auto result = std::from_chars(strValue.data(), strValue.data() + strValue.size(), iLength);
+				iContentLength = result.ec == std::errc{} ? iLength : -1;
+			} else if (equalsIgnoreCase(strKey, "Transfer-Encoding")) {
+				bChunked = containsToken(strValue, "chunked");
+			} else if (equalsIgnoreCase(strKey, "Connection")) {
+				if (containsToken(strValue, "close")) {
+					bKeepAlive = false;
+				} else if (containsToken(strValue, "keep-alive")) {
+					bKeepAlive = true;
+				}
+			}
+			return;
+		}
+		case State::ChunkSize: {
+			std::string_view strSize = trimWhitespace(strLine.substr(0, strLine.find(';')));
+			std::uint64_t iChunkSize = 0;
+			auto result = std::from_chars(strSize.data(), strSize.data() + strSize.size(), iChunkSize, 16);
+			if (result.ec != std::errc{} || strSize.empty()) {
+				eState = State::Error;
+				return;
+			}
+			iRemaining = iChunkSize;
+			eState = iChunkSize == 0 ? State::Trailers : State::ChunkData;
+			return;
+		}
+		case State::ChunkDataEnd:
+			eState = strLine.empty() ? State::ChunkSize : State::Error;
+			return;
+		case State::Trailers:
+			if (strLine.empty()) {
+				eState = State::Done;
+			}
+			return;
+		default:
+			return;
+	}
+}
+
+void CHttp1ResponseParser::onHeadersComplete() {
+	unsigned int iStatusCode = pResponse->iStatusCode;
+	
+	// interim responses are followed by the real one on the same stream
+	if (iStatusCode >= 100 && iStatusCode < 200) {
+		pResponse->vecHeaders.clear();
+		iContentLength = -1;
+		bChunked = false;
+		eState = State::StatusLine;
+		return;
+	}
+	
+	if (bNoBody || iStatusCode == 204 || iStatusCode == 304) {
+		eState = State::Done;
+	} else if (bChunked) {
+		eState = State::ChunkSize;
+	} else if (iContentLength >= 0) {
+		iRemaining = static_cast<std::uint64_t>(iContentLength);
+		if (pBufferPool && iRemaining <= CBufferPool::SIZE_CLASSES.back()) {
+			pBufferPool->reserve(pResponse->strBody, static_cast<size_t>(iRemaining));
+		}
+		eState = iRemaining == 0 ? State::Done : State::Body;
+	} else {
+		bKeepAlive = false;
+		eState = State::UntilClose;
+	}
+}
+
+void CHttp1ResponseParser::appendBody(const char* pData, size_t iLength) {
+	std::string& strBody = pResponse->strBody;
+	if (pBufferPool && strBody.size() + iLength > strBody.capacity()) {
+		pBufferPool->reserve(strBody, std::max(strBody.size() + iLength, strBody.size() * 2));
+	}
+	strBody.append(pData, iLength);
+}
+
+void CHttp1ResponseParser::finishOnClose() noexcept {
+	if (eState == State::UntilClose) {
+		eState = State::Done;
+	}
+}
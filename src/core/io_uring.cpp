@@ -0,0 +1,146 @@
+#include "core/io_uring.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int ioUringSetup(unsigned int iEntries, io_uring_params* pParams) noexcept {
+	return static_cast<int>(::syscall(__NR_io_uring_setup, iEntries, pParams));
+}
+
+static int ioUringEnter(int iFd, unsigned int iToSubmit, unsigned int iMinComplete, unsigned int iFlags) noexcept {
+	return static_cast<int>(::syscall(__NR_io_uring_enter, iFd, iToSubmit, iMinComplete, iFlags, nullptr, 0));
+}
+
+CIoUring::CIoUring(unsigned int iEntries) {
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	
+	int iFd = ioUringSetup(iEntries, &params);
+	if (iFd < 0) {
+		return;
+	}
+	
+	iSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	iCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool bSingleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (bSingleMmap) {
+		iSqRingSize = iCqRingSize = iSqRingSize > iCqRingSize ? iSqRingSize : iCqRingSize;
+	}
+	
+	pSqRing = ::mmap(nullptr, iSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_SQ_RING);
+	if (pSqRing == MAP_FAILED) {
+		pSqRing = nullptr;
+		::close(iFd);
+		return;
+	}
+	
+	if (bSingleMmap) {
+		pCqRing = pSqRing;
+	} else {
+		pCqRing = ::mmap(nullptr, iCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_CQ_RING);
+		if (pCqRing == MAP_FAILED) {
+			pCqRing = nullptr;
+			::munmap(pSqRing, iSqRingSize);
+			pSqRing = nullptr;
+			::close(iFd);
+			return;
+		}
+	}
+	
+	iSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* pSqesMemory = ::mmap(nullptr, iSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFd, IORING_OFF_SQES);
+	if (pSqesMemory == MAP_FAILED) {
+		if (pCqRing != pSqRing) {
+			::munmap(pCqRing, iCqRingSize);
+		}
+		::munmap(pSqRing, iSqRingSize);
+		pSqRing = pCqRing = nullptr;
+		::close(iFd);
+		return;
+	}
+	pSqes = static_cast<io_uring_sqe*>(pSqesMemory);
+	
+	char* pSq = static_cast<char*>(pSqRing);
+	pSqHead = reinterpret_cast<unsigned int*>(pSq + params.sq_off.head);
+	pSqTail = reinterpret_cast<unsigned int*>(pSq + params.sq_off.tail);
+	pSqArray = reinterpret_cast<unsigned int*>(pSq + params.sq_off.array);
+	iSqMask = *reinterpret_cast<unsigned int*>(pSq + params.sq_off.ring_mask);
+	iSqEntries = params.sq_entries;
+	
+	char* pCq = static_cast<char*>(pCqRing);
+	pCqHead = reinterpret_cast<unsigned int*>(pCq + params.cq_off.head);
+	pCqTail = reinterpret_cast<unsigned int*>(pCq + params.cq_off.tail);
+	pCqes = reinterpret_cast<io_uring_cqe*>(pCq + params.cq_off.cqes);
+	iCqMask = *reinterpret_cast<unsigned int*>(pCq + params.cq_off.ring_mask);
+	
+	iRingFd = iFd;
+}
+
+CIoUring::~CIoUring() {
+	if (iRingFd < 0) {
+		return;
+	}
+	
+	::munmap(pSqes, iSqesSize);
+	if (pCqRing != pSqRing) {
+		::munmap(pCqRing, iCqRingSize);
+	}
+	::munmap(pSqRing, iSqRingSize);
+	::close(iRingFd);
+}
+
+io_uring_sqe* CIoUring::prepare(std::uint8_t iOpcode, int iFd, std::uint64_t iUserData) noexcept {
+	unsigned int iHead = std::atomic_ref<unsigned int>(*pSqHead).load(std::memory_order_acquire);
+	unsigned int iTail = *pSqTail + iPending;
+	if (iTail - iHead >= iSqEntries) {
+		return nullptr;
+	}
+	
+	unsigned int iIndex = iTail & iSqMask;
+	io_uring_sqe* pSqe = &pSqes[iIndex];
+	std::memset(pSqe, 0, sizeof(io_uring_sqe));
+	pSqe->opcode = iOpcode;
+	pSqe->fd = iFd;
+	pSqe->user_data = iUserData;
+	
+	pSqArray[iIndex] = iIndex;
+	++iPending;
+	return pSqe;
+}
+
+int CIoUring::submitAndWait(unsigned int iWaitCount) noexcept {
+	unsigned int iToSubmit = iPending;
+	if (iToSubmit > 0) {
+		std::atomic_ref<unsigned int>(*pSqTail).store(*pSqTail + iToSubmit, std::memory_order_release);
+		iPending = 0;
+	}
+	
+	while (true) {
+		int iResult = ioUringEnter(iRingFd, iToSubmit, iWaitCount, iWaitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+		if (iResult >= 0) {
+			return iResult;
+		}
+		if (errno != EINTR) {
+			return -errno;
+		}
+		// anything already consumed by the kernel must not be submitted twice
+		iToSubmit = 0;
+	}
+}
+
+bool CIoUring::popCompletion(io_uring_cqe& cqeResult) noexcept {
+	unsigned int iHead = *pCqHead;
+	unsigned int iTail = std::atomic_ref<unsigned int>(*pCqTail).load(std::memory_order_acquire);
+	if (iHead == iTail) {
+		return false;
+	}
+	
+	cqeResult = pCqes[iHead & iCqMask];
+	std::atomic_ref<unsigned int>(*pCqHead).store(iHead + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,523 @@
+#include "core/native_transport.hpp"
+#include "core/dns_cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+enum : std::uint64_t {
+	TAG_SEND = 1,
+	TAG_SEND_TIMEOUT,
+	TAG_RECEIVE,
+	TAG_RECEIVE_TIMEOUT,
+	TAG_CANCEL
+};
+
+int remainingMilliseconds(std::chrono::steady_clock::time_point timeDeadline) noexcept {
+	auto timeRemaining = std::chrono::duration_cast<std::chrono::milliseconds>(timeDeadline - std::chrono::steady_clock::now());
+	return timeRemaining.count() > 0 ? static_cast<int>(timeRemaining.count()) : 0;
+}
+
+size_t iovecBytes(const iovec* pIovecs, int iIovecCount) noexcept {
+	size_t iTotal = 0;
+	for (int i = 0; i < iIovecCount; ++i) {
+		iTotal += pIovecs[i].iov_len;
+	}
+	return iTotal;
+}
+
+// drops iSent bytes from the front of the iovec array after a short send
+void advanceIovecs(iovec*& pIovecs, int& iIovecCount, size_t iSent) noexcept {
+	while (iIovecCount > 0 && iSent >= pIovecs->iov_len) {
+		iSent -= pIovecs->iov_len;
+		++pIovecs;
+		--iIovecCount;
+	}
+	if (iIovecCount > 0) {
+		pIovecs->iov_base = static_cast<char*>(pIovecs->iov_base) + iSent;
+		pIovecs->iov_len -= iSent;
+	}
+}
+
+}  // namespace
+
+CNativeHttpTransport::CNativeHttpTransport() : ringIo(16), vecReceiveBuffer(RECEIVE_BUFFER_SIZE) {
+}
+
+CNativeHttpTransport::~CNativeHttpTransport() {
+	for (auto& [strAuthority, vecSockets] : mapIdleSockets) {
+		for (int iSocket : vecSockets) {
+			::close(iSocket);
+		}
+	}
+}
+
+bool CNativeHttpTransport::supports(std::string_view strFullURL) noexcept {
+	return strFullURL.size() > 7 && strncasecmp(strFullURL.data(), "http://", 7) == 0;
+}
+
+size_t CNativeHttpTransport::getIdleSocketCount() const noexcept {
+	size_t iCount = 0;
+	for (const auto& [strAuthority, vecSockets] : mapIdleSockets) {
+		iCount += vecSockets.size();
+	}
+	return iCount;
+}
+
+bool CNativeHttpTransport::parseTarget(std::string_view strFullURL, Target& target) {
+	if (!supports(strFullURL)) {
+		return false;
+	}
+	
+	std::string_view strRest = strFullURL.substr(7);
+	size_t iPathStart = strRest.find_first_of("/?#");
+	target.strAuthority = strRest.substr(0, iPathStart);
+	
+	// credentials in the url and query-only targets are left to curl
+	if (target.strAuthority.empty() || target.strAuthority.find('@') != std::string_view::npos) {
+		return false;
+	}
+	if (iPathStart != std::string_view::npos && strRest[iPathStart] == '?') {
+		return false;
+	}
+	
+	target.strPath = iPathStart == std::string_view::npos ? std::string_view("/") : strRest.substr(iPathStart);
+	target.strPath = target.strPath.substr(0, target.strPath.find('#'));
+	if (target.strPath.empty()) {
+		target.strPath = "/";
+	}
+	
+	std::string_view strPort;
+	if (target.strAuthority.front() == '[') {
+		size_t iClose = target.strAuthority.find(']');
+		if (iClose == std::string_view::npos) {
+			return false;
+		}
+		target.strHost.assign(target.strAuthority.substr(1, iClose - 1));
+		std::string_view strAfter = target.strAuthority.substr(iClose + 1);
+		if (!strAfter.empty()) {
+			if (strAfter.front() != ':') {
+				return false;
+			}
+			strPort = strAfter.substr(1);
+		}
+	} else {
+		size_t iColon = target.strAuthority.rfind(':');
+		target.strHost.assign(target.strAuthority.substr(0, iColon));
+		if (iColon != std::string_view::npos) {
+			strPort = target.strAuthority.substr(iColon + 1);
+		}
+	}
+	
+	target.strPort.assign(strPort.empty() ? std::string_view("80") : strPort);
+	return !target.strHost.empty();
+}
+
+int CNativeHttpTransport::connectSocket(const Target& target, Deadline timeDeadline, CDnsCache* pResolver) {
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	
+	// cached addresses are numeric, getaddrinfo only builds the sockaddr
+	std::vector<std::string> vecCached;
+	if (pResolver && pResolver->lookup(target.strHost, vecCached)) {
+		hints.ai_flags = AI_NUMERICHOST;
+		
+		int iResult = -EHOSTUNREACH;
+		for (const auto& strAddress : vecCached) {
+			addrinfo* pAddresses = nullptr;
+			if (::getaddrinfo(strAddress.c_str(), target.strPort.c_str(), &hints, &pAddresses) != 0 || !pAddresses) {
+				continue;
+			}
+			iResult = connectAny(pAddresses, timeDeadline);
+			::freeaddrinfo(pAddresses);
+			if (iResult >= 0) {
+				break;
+			}
+		}
+		return iResult;
+	}
+	
+	addrinfo* pAddresses = nullptr;
+	if (::getaddrinfo(target.strHost.c_str(), target.strPort.c_str(), &hints, &pAddresses) != 0 || !pAddresses) {
+		return -EHOSTUNREACH;
+	}
+	
+	int iResult = connectAny(pAddresses, timeDeadline);
+	::freeaddrinfo(pAddresses);
+	return iResult;
+}
+
+int CNativeHttpTransport::connectAny(addrinfo* pAddresses, Deadline timeDeadline) {
+	int iResult = -ECONNREFUSED;
+	for (addrinfo* pAddress = pAddresses; pAddress; pAddress = pAddress->ai_next) {
+		int iSocket = ::socket(pAddress->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (iSocket < 0) {
+			iResult = -errno;
+			continue;
+		}
+		
+		if (::connect(iSocket, pAddress->ai_addr, pAddress->ai_addrlen) == 0 || errno == EINPROGRESS) {
+			int iWait = std::min(remainingMilliseconds(timeDeadline), static_cast<int>(CONNECT_TIMEOUT.count()));
+			pollfd pollSocket{iSocket, POLLOUT, 0};
+			int iReady = ::poll(&pollSocket, 1, iWait);
+			
+			int iSocketError = 0;
+			socklen_t iErrorLength = sizeof(iSocketError);
+			if (iReady > 0) {
+				::getsockopt(iSocket, SOL_SOCKET, SO_ERROR, &iSocketError, &iErrorLength);
+			}
+			
+			if (iReady > 0 && iSocketError == 0) {
+				// the ring and poll paths both expect a blocking socket
+				::fcntl(iSocket, F_SETFL, ::fcntl(iSocket, F_GETFL) & ~O_NONBLOCK);
+				int iNoDelay = 1;
+				::setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iNoDelay, sizeof(iNoDelay));
+				return iSocket;
+			}
+			iResult = iReady == 0 ? -ETIMEDOUT : -(iSocketError ? iSocketError : errno);
+		} else {
+			iResult = -errno;
+		}
+		
+		::close(iSocket);
+	}
+	
+	return iResult;
+}
+
+int CNativeHttpTransport::acquireSocket(const Target& target, Deadline timeDeadline, CDnsCache* pResolver, bool& bReused) {
+	auto it = mapIdleSockets.find(target.strAuthority);
+	if (it != mapIdleSockets.end() && !it->second.empty()) {
+		int iSocket = it->second.back();
+		it->second.pop_back();
+		bReused = true;
+		return iSocket;
+	}
+	
+	bReused = false;
+	return connectSocket(target, timeDeadline, pResolver);
+}
+
+void CNativeHttpTransport::releaseSocket(std::string_view strAuthority, int iSocket) {
+	auto it = mapIdleSockets.find(strAuthority);
+	if (it == mapIdleSockets.end()) {
+		it = mapIdleSockets.emplace(std::string(strAuthority), std::vector<int>{}).first;
+	}
+	
+	if (it->second.size() >= MAX_IDLE_SOCKETS_PER_HOST) {
+		::close(iSocket);
+		return;
+	}
+	it->second.push_back(iSocket);
+}
+
+int CNativeHttpTransport::exchange(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable) {
+	if (ringIo.isAvailable()) {
+		return exchangeRing(iSocket, pIovecs, iIovecCount, parser, timeDeadline, bReusable);
+	}
+	return exchangePoll(iSocket, pIovecs, iIovecCount, parser, timeDeadline, bReusable);
+}
+
+int CNativeHttpTransport::exchangeRing(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable) {
+	size_t iSendRemaining = iovecBytes(pIovecs, iIovecCount);
+	msghdr messageSend;
+	std::memset(&messageSend, 0, sizeof(messageSend));
+	__kernel_timespec timeSendLimit{};
+	__kernel_timespec timeReceiveLimit{};
+	
+	unsigned int iOutstanding = 0;
+	bool bSendPending = false;
+	bool bReceivePending = false;
+	bool bCancelQueued = false;
+	bool bTimedOut = false;
+	bool bDone = false;
+	bool bTrailingBytes = false;
+	int iError = 0;
+	
+	// every operation is chained to its own LINK_TIMEOUT, so a stalled peer
+	// cancels it and both complete with a cqe we wait for below
+	auto queueWithTimeout = [&](io_uring_sqe* pSqe, __kernel_timespec& timeLimit, std::uint64_t iTimeoutTag) {
+		int iWait = remainingMilliseconds(timeDeadline);
+		timeLimit.tv_sec = iWait / 1000;
+		timeLimit.tv_nsec = static_cast<long long>(iWait % 1000) * 1000000;
+		pSqe->flags |= IOSQE_IO_LINK;
+		
+		io_uring_sqe* pTimeout = ringIo.prepare(IORING_OP_LINK_TIMEOUT, -1, iTimeoutTag);
+		pTimeout->addr = reinterpret_cast<std::uintptr_t>(&timeLimit);
+		pTimeout->len = 1;
+		iOutstanding += 2;
+	};
+	
+	auto queueSend = [&]() {
+		messageSend.msg_iov = pIovecs;
+		messageSend.msg_iovlen = static_cast<size_t>(iIovecCount);
+		io_uring_sqe* pSqe = ringIo.prepare(IORING_OP_SENDMSG, iSocket, TAG_SEND);
+		pSqe->addr = reinterpret_cast<std::uintptr_t>(&messageSend);
+		pSqe->len = 1;
+		pSqe->msg_flags = MSG_NOSIGNAL;
+		queueWithTimeout(pSqe, timeSendLimit, TAG_SEND_TIMEOUT);
+		bSendPending = true;
+	};
+	
+	auto queueReceive = [&]() {
+		io_uring_sqe* pSqe = ringIo.prepare(IORING_OP_RECV, iSocket, TAG_RECEIVE);
+		pSqe->addr = reinterpret_cast<std::uintptr_t>(vecReceiveBuffer.data());
+		pSqe->len = static_cast<unsigned int>(vecReceiveBuffer.size());
+		queueWithTimeout(pSqe, timeReceiveLimit, TAG_RECEIVE_TIMEOUT);
+		bReceivePending = true;
+	};
+	
+	// request and first read go to the kernel in a single io_uring_enter
+	queueSend();
+	queueReceive();
+	
+	while (iOutstanding > 0) {
+		int iSubmitted = ringIo.submitAndWait(1);
+		if (iSubmitted < 0) {
+			return iSubmitted;
+		}
+		
+		io_uring_cqe cqe;
+		while (ringIo.popCompletion(cqe)) {
+			--iOutstanding;
+			
+			switch (cqe.user_data) {
+				case TAG_SEND:
+					bSendPending = false;
+					if (cqe.res < 0) {
+						if (cqe.res != -ECANCELED && iError == 0) {
+							iError = cqe.res;
+						}
+						break;
+					}
+					iSendRemaining -= static_cast<size_t>(cqe.res);
+					advanceIovecs(pIovecs, iIovecCount, static_cast<size_t>(cqe.res));
+					if (iSendRemaining > 0 && !bDone && iError == 0 && !bTimedOut) {
+						queueSend();
+					}
+					break;
+				case TAG_RECEIVE: {
+					bReceivePending = false;
+					if (cqe.res < 0) {
+						if (cqe.res != -ECANCELED && iError == 0) {
+							iError = cqe.res;
+						}
+						break;
+					}
+					if (cqe.res == 0) {
+						parser.finishOnClose();
+						bDone = parser.isDone();
+						bTrailingBytes = true;
+						if (!bDone && iError == 0) {
+							iError = -ECONNRESET;
+						}
+						break;
+					}
+					size_t iConsumed = parser.feed(vecReceiveBuffer.data(), static_cast<size_t>(cqe.res));
+					if (parser.isError()) {
+						iError = -EPROTO;
+					} else if (parser.isDone()) {
+						bDone = true;
+						bTrailingBytes = iConsumed < static_cast<size_t>(cqe.res);
+					} else if (iError == 0 && !bTimedOut) {
+						queueReceive();
+					}
+					break;
+				}
+				case TAG_SEND_TIMEOUT:
+				case TAG_RECEIVE_TIMEOUT:
+					if (cqe.res == -ETIME) {
+						bTimedOut = true;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		
+		// nothing may still point into this frame once we return
+		if ((bDone || iError != 0 || bTimedOut) && (bSendPending || bReceivePending) && !bCancelQueued) {
+			for (std::uint64_t iTag : {TAG_SEND, TAG_RECEIVE}) {
+				if ((iTag == TAG_SEND && !bSendPending) || (iTag == TAG_RECEIVE && !bReceivePending)) {
+					continue;
+				}
+				io_uring_sqe* pCancel = ringIo.prepare(IORING_OP_ASYNC_CANCEL, -1, TAG_CANCEL);
+				pCancel->addr = iTag;
+				++iOutstanding;
+			}
+			bCancelQueued = true;
+		}
+	}
+	
+	if (bDone) {
+		bReusable = parser.isKeepAlive() && iSendRemaining == 0 && !bTrailingBytes;
+		return 0;
+	}
+	return bTimedOut ? -ETIMEDOUT : (iError != 0 ? iError : -EIO);
+}
+
+int CNativeHttpTransport::exchangePoll(int iSocket, iovec* pIovecs, int iIovecCount, CHttp1ResponseParser& parser, Deadline timeDeadline, bool& bReusable) {
+	size_t iSendRemaining = iovecBytes(pIovecs, iIovecCount);
+	
+	while (true) {
+		int iWait = remainingMilliseconds(timeDeadline);
+		if (iWait == 0) {
+			return -ETIMEDOUT;
+		}
+		
+		pollfd pollSocket{iSocket, static_cast<short>(POLLIN | (iSendRemaining > 0 ? POLLOUT : 0)), 0};
+		int iReady = ::poll(&pollSocket, 1, iWait);
+		if (iReady < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -errno;
+		}
+		if (iReady == 0) {
+			return -ETIMEDOUT;
+		}
+		
+		// the response is read first, a server may answer and close before
+		// it has taken the whole body
+		if (pollSocket.revents & (POLLIN | POLLERR | POLLHUP)) {
+			ssize_t iReceived = ::recv(iSocket, vecReceiveBuffer.data(), vecReceiveBuffer.size(), MSG_DONTWAIT);
+			if (iReceived < 0 && errno != EAGAIN && errno != EINTR) {
+				return -errno;
+			}
+			if (iReceived == 0) {
+				parser.finishOnClose();
+				bReusable = false;
+				return parser.isDone() ? 0 : -ECONNRESET;
+			}
+			if (iReceived > 0) {
+				size_t iConsumed = parser.feed(vecReceiveBuffer.data(), static_cast<size_t>(iReceived));
+				if (parser.isError()) {
+					return -EPROTO;
+				}
+				if (parser.isDone()) {
+					bReusable = parser.isKeepAlive() && iSendRemaining == 0 && iConsumed == static_cast<size_t>(iReceived);
+					return 0;
+				}
+			}
+		}
+		
+		if (iSendRemaining > 0 && (pollSocket.revents & (POLLOUT | POLLERR | POLLHUP))) {
+			msghdr messageSend;
+			std::memset(&messageSend, 0, sizeof(messageSend));
+			messageSend.msg_iov = pIovecs;
+			messageSend.msg_iovlen = static_cast<size_t>(iIovecCount);
+			
+			ssize_t iSent = ::sendmsg(iSocket, &messageSend, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if (iSent < 0 && errno != EAGAIN && errno != EINTR) {
+				return -errno;
+			}
+			if (iSent > 0) {
+				iSendRemaining -= static_cast<size_t>(iSent);
+				advanceIovecs(pIovecs, iIovecCount, static_cast<size_t>(iSent));
+			}
+		}
+	}
+}
+
+CNativeHttpTransport::Result CNativeHttpTransport::perform(const Request& request, std::string_view strFullURL, Response& response, CBufferPool* pBufferPool, std::chrono::milliseconds timeTimeout, CDnsCache* pResolver) {
+	Target target;
+	if (request.bodyRequest.isChunked() || !parseTarget(strFullURL, target)) {
+		return Result::Fallback;
+	}
+	
+	Deadline timeDeadline = std::chrono::steady_clock::now() + timeTimeout;
+	std::string_view strBody = request.bodyRequest.view();
+	CHttp1Serializer::writeRequestHead(strRequestHead, request.eMethod, target.strPath, target.strAuthority, request.getHeaders(), strBody.size());
+	
+	CHttp1ResponseParser parser;
+	int iResult = 0;
+	
+	for (int iAttempt = 0; iAttempt < 2; ++iAttempt) {
+		bool bReused = false;
+		int iSocket = acquireSocket(target, timeDeadline, pResolver, bReused);
+		if (iSocket < 0) {
+			iResult = iSocket;
+			break;
+		}
+		
+		response.iStatusCode = 0;
+		response.strBody.clear();
+		response.vecHeaders.clear();
+		parser.reset(&response, pBufferPool, request.eMethod == HttpMethod::Head);
+		
+		// head and body go out as two iovecs, the body is never copied
+		iovec arrIovecs[2] = {
+			{strRequestHead.data(), strRequestHead.size()},
+			{const_cast<char*>(strBody.data()), strBody.size()}
+		};
+		int iIovecCount = strBody.empty() ? 1 : 2;
+		
+		bool bReusable = false;
+		iResult = exchange(iSocket, arrIovecs, iIovecCount, parser, timeDeadline, bReusable);
+		if (iResult == 0) {
+			if (bReusable) {
+				releaseSocket(target.strAuthority, iSocket);
+			} else {
+				::close(iSocket);
+			}
+			break;
+		}
+		
+		::close(iSocket);
+		
+		// a kept-alive socket the server already closed fails before the
+		// first response byte, that is retried once on a fresh connection
+		if (!bReused || parser.hasStarted() || iResult == -ETIMEDOUT) {
+			break;
+		}
+	}
+	
+	if (iResult == 0) {
+		bool bRedirect = CUtils::isRedirectStatusCode(response.iStatusCode) && request.eMethod != HttpMethod::Post && 
+		                 std::any_of(response.vecHeaders.begin(), response.vecHeaders.end(), [](const auto& header) {
+		                     return strcasecmp(header.first.c_str(), "Location") == 0;
+		                 });
+		if (bRedirect) {
+			response.iStatusCode = 0;
+			response.strBody.clear();
+			response.vecHeaders.clear();
+			return Result::Fallback;
+		}
+		return Result::Completed;
+	}
+	
+	response.vecHeaders.clear();
+	switch (-iResult) {
+		case ETIMEDOUT:
+			response.iStatusCode = 408;
+			response.eError = ResponseError::Timeout;
+			response.strBody = "Request timeout";
+			break;
+		case ECONNREFUSED:
+		case EHOSTUNREACH:
+		case ENETUNREACH:
+			response.iStatusCode = 503;
+			response.eError = ResponseError::ConnectFailed;
+			response.strBody = "Connection failed";
+			break;
+		default:
+			response.iStatusCode = 500;
+			response.eError = ResponseError::TransportFailed;
+			response.strBody = "Native transport error: " + std::string(std::strerror(-iResult));
+			break;
+	}
+	return Result::Completed;
+}
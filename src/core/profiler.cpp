@@ -0,0 +1,90 @@
+#include "core/profiler.hpp"
+
+#include <thread>
+
+CHotPathProfiler::CHotPathProfiler() : iCalibrationCycles(readCycles()), timeCalibration(std::chrono::steady_clock::now()) {
+}
+
+void CHotPathProfiler::record(ProfileStage eStage, std::uint64_t iCycles) noexcept {
+	StageCounters& counters = arrStages[static_cast<size_t>(eStage)];
+	counters.iSamples.fetch_add(1, std::memory_order_relaxed);
+	counters.iCycles.fetch_add(iCycles, std::memory_order_relaxed);
+	
+	std::uint64_t iMax = counters.iMaxCycles.load(std::memory_order_relaxed);
+	while (iCycles > iMax && !counters.iMaxCycles.compare_exchange_weak(iMax, iCycles, std::memory_order_relaxed)) {
+	}
+}
+
+double CHotPathProfiler::getCyclesPerNanosecond() const {
+	constexpr auto timeMinWindow = std::chrono::milliseconds(10);
+	
+	auto timeElapsed = std::chrono::steady_clock::now() - timeCalibration;
+	if (timeElapsed < timeMinWindow) {
+		std::this_thread::sleep_for(timeMinWindow - timeElapsed);
+	}
+	
+	std::uint64_t iCycles = readCycles() - iCalibrationCycles;
+	auto iNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeCalibration).count();
+	return iNanos > 0 ? static_cast<double>(iCycles) / static_cast<double>(iNanos) : 1.0;
+}
+
+std::chrono::nanoseconds CHotPathProfiler::toNanoseconds(std::uint64_t iCycles) const {
+	return std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(iCycles) / getCyclesPerNanosecond()));
+}
+
+std::vector<StageStats> CHotPathProfiler::getStageStats() const {
+	double dCyclesPerNano = getCyclesPerNanosecond();
+	
+	std::vector<StageStats> vecStats;
+	vecStats.reserve(arrStages.size());
+	for (size_t i = 0; i < arrStages.size(); ++i) {
+		StageStats stats;
+		stats.strName = getStageName(static_cast<ProfileStage>(i));
+		stats.iSamples = arrStages[i].iSamples.load(std::memory_order_relaxed);
+		stats.iTotalCycles = arrStages[i].iCycles.load(std::memory_order_relaxed);
+		if (stats.iSamples > 0) {
+			stats.timeMean = std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(stats.iTotalCycles) / static_cast<double>(stats.iSamples) / dCyclesPerNano));
+		}
+		stats.timeMax = std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(arrStages[i].iMaxCycles.load(std::memory_order_relaxed)) / dCyclesPerNano));
+		vecStats.push_back(std::move(stats));
+	}
+	return vecStats;
+}
+
+void CHotPathProfiler::reset() noexcept {
+	for (auto& counters : arrStages) {
+		counters.iSamples.store(0, std::memory_order_relaxed);
+		counters.iCycles.store(0, std::memory_order_relaxed);
+		counters.iMaxCycles.store(0, std::memory_order_relaxed);
+	}
+}
+
+const char* CHotPathProfiler::getStageName(ProfileStage eStage) noexcept {
+	switch (eStage) {
+		case ProfileStage::Enqueue: return "enqueue";
+		case ProfileStage::Dequeue: return "dequeue";
+		case ProfileStage::Checkout: return "checkout";
+		case ProfileStage::Transfer: return "transfer";
+		case ProfileStage::Completion: return "completion";
+		default: return "unknown";
+	}
+}
+
+LockStats CInstrumentedMutex::getStats(std::string strName) const {
+	LockStats stats;
+	stats.strName = std::move(strName);
+	stats.iAcquisitions = iAcquisitions.load(std::memory_order_relaxed);
+	stats.iContended = iContended.load(std::memory_order_relaxed);
+	if (pProfiler) {
+		stats.timeWaited = pProfiler->toNanoseconds(iWaitCycles.load(std::memory_order_relaxed));
+		stats.timeMaxWait = pProfiler->toNanoseconds(iMaxWaitCycles.load(std::memory_order_relaxed));
+	}
+	return stats;
+}
+
+void CInstrumentedMutex::resetStats() noexcept {
+	iAcquisitions.store(0, std::memory_order_relaxed);
+	iContended.store(0, std::memory_order_relaxed);
+	iWaitCycles.store(0, std::memory_order_relaxed);
+	iMaxWaitCycles.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+#include "core/request_body.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+class CMappedFile {
+ public:
+	explicit CMappedFile(const std::string& strPath) {
+		int iFd = ::open(strPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (iFd < 0) {
+			throw std::runtime_error("Failed to open " + strPath + ": " + std::strerror(errno));
+		}
+		
+		struct stat statFile{};
+		if (::fstat(iFd, &statFile) != 0) {
+			int iError = errno;
+			::close(iFd);
+			throw std::runtime_error("Failed to stat " + strPath + ": " + std::strerror(iError));
+		}
+		
+		iLength = static_cast<size_t>(statFile.st_size);
+		if (iLength > 0) {
+			pData = ::mmap(nullptr, iLength, PROT_READ, MAP_PRIVATE, iFd, 0);
+			if (pData == MAP_FAILED) {
+				int iError = errno;
+				::close(iFd);
+				pData = nullptr;
+				throw std::runtime_error("Failed to map " + strPath + ": " + std::strerror(iError));
+			}
+			::madvise(pData, iLength, MADV_SEQUENTIAL);
+		}
+		
+		::close(iFd);
+	}
+	
+	~CMappedFile() {
+		if (pData) {
+			::munmap(pData, iLength);
+		}
+	}
+	
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile& operator=(const CMappedFile&) = delete;
+	
+	std::string_view view() const noexcept {
+		return std::string_view(static_cast<const char*>(pData), iLength);
+	}
+	
+ private:
+	void* pData{nullptr};
+	size_t iLength{0};
+};
+
+}  // namespace
+
+CRequestBody CRequestBody::owned(std::string strBody) {
+	CRequestBody body;
+	if (strBody.empty()) {
+		return body;
+	}
+	
+	auto pBody = std::make_shared<const std::string>(std::move(strBody));
+	body.strView = *pBody;
+	body.pOwner = std::move(pBody);
+	return body;
+}
+
+CRequestBody CRequestBody::copy(std::string_view strBody) {
+	return owned(std::string(strBody));
+}
+
+CRequestBody CRequestBody::shared(std::shared_ptr<const std::string> pBody) {
+	CRequestBody body;
+	if (pBody) {
+		body.strView = *pBody;
+		body.pOwner = std::move(pBody);
+	}
+	return body;
+}
+
+CRequestBody CRequestBody::borrowed(std::string_view strBody) noexcept {
+	CRequestBody body;
+	body.strView = strBody;
+	return body;
+}
+
+CRequestBody CRequestBody::mappedFile(const std::string& strPath, bool bChunked) {
+	auto pFile = std::make_shared<const CMappedFile>(strPath);
+	
+	CRequestBody body;
+	body.strView = pFile->view();
+	body.pOwner = std::move(pFile);
+	body.bStreamed = true;
+	body.bChunked = bChunked;
+	return body;
+}
@@ -0,0 +1,126 @@
+#include "core/request_coalescer.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+static std::string toLowerCase(std::string_view strInput) {
+	std::string strResult(strInput);
+	std::transform(strResult.begin(), strResult.end(), strResult.begin(), [](unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+	return strResult;
+}
+
+void CRequestCoalescer::setKeyHeaders(std::vector<std::string> vecHeaderNames) {
+	for (auto& strName : vecHeaderNames) {
+		strName = toLowerCase(strName);
+	}
+	
+	std::lock_guard<std::mutex> lock(mutexKeyHeaders);
+	vecKeyHeaders = std::move(vecHeaderNames);
+}
+
+std::string CRequestCoalescer::buildKey(std::string_view strMethod, std::string_view strFullURL, const std::vector<std::pair<std::string, std::string>>& vecHeaders) const {
+	std::vector<std::string> vecLines;
+	vecLines.reserve(vecHeaders.size());
+	
+	{
+		std::lock_guard<std::mutex> lock(mutexKeyHeaders);
+		for (const auto& header : vecHeaders) {
+			std::string strName = toLowerCase(header.first);
+			if (!vecKeyHeaders.empty() && std::find(vecKeyHeaders.begin(), vecKeyHeaders.end(), strName) == vecKeyHeaders.end()) {
+				continue;
+			}
+			vecLines.push_back(std::move(strName) + ':' + header.second);
+		}
+	}
+	
+	// header order must not split otherwise identical requests
+	std::sort(vecLines.begin(), vecLines.end());
+	
+	std::string strKey;
+	strKey.reserve(strMethod.size() + strFullURL.size() + 2);
+	strKey.append(strMethod).append(1, '\n').append(strFullURL).append(1, '\n');
+	for (const auto& strLine : vecLines) {
+		strKey.append(strLine).append(1, '\n');
+	}
+	return strKey;
+}
+
+CRequestCoalescer::InFlight& CRequestCoalescer::lead(const std::string& strKey, Request& request) {
+	auto& inFlight = mapInFlight[strKey];
+	
+	auto fnPrevious = std::move(request.fnOnComplete);
+	request.fnOnComplete = [this, strKey, fnPrevious = std::move(fnPrevious)](const Request& requestDone, Response& response) {
+		if (fnPrevious) {
+			fnPrevious(requestDone, response);
+		}
+		complete(strKey, response);
+	};
+	
+	return inFlight;
+}
+
+bool CRequestCoalescer::join(const std::string& strKey, Request& request, std::future<Response>& futureResult) {
+	std::lock_guard<std::mutex> lock(mutexInFlight);
+	
+	auto it = mapInFlight.find(strKey);
+	if (it != mapInFlight.end()) {
+		auto& promiseWaiter = it->second.vecWaiters.emplace_back();
+		futureResult = promiseWaiter.get_future();
+		iCoalescedRequests.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	
+	lead(strKey, request);
+	futureResult = request.promiseResponse.get_future();
+	return true;
+}
+
+bool CRequestCoalescer::joinShared(const std::string& strKey, Request& request, std::shared_future<Response>& futureResult) {
+	std::lock_guard<std::mutex> lock(mutexInFlight);
+	
+	auto it = mapInFlight.find(strKey);
+	if (it != mapInFlight.end()) {
+		auto& inFlight = it->second;
+		if (!inFlight.futureShared.valid()) {
+			inFlight.futureShared = inFlight.promiseShared.get_future().share();
+			inFlight.bOwnsSharedPromise = true;
+		}
+		futureResult = inFlight.futureShared;
+		iCoalescedRequests.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	
+	auto& inFlight = lead(strKey, request);
+	inFlight.futureShared = request.promiseResponse.get_future().share();
+	futureResult = inFlight.futureShared;
+	return true;
+}
+
+void CRequestCoalescer::complete(const std::string& strKey, const Response& response) {
+	InFlight inFlight;
+	{
+		std::lock_guard<std::mutex> lock(mutexInFlight);
+		auto it = mapInFlight.find(strKey);
+		if (it == mapInFlight.end()) {
+			return;
+		}
+		inFlight = std::move(it->second);
+		mapInFlight.erase(it);
+	}
+	
+	// shared followers all read the same refcounted result, only plain
+	// std::future waiters need their own copy
+	if (inFlight.bOwnsSharedPromise) {
+		inFlight.promiseShared.set_value(response);
+	}
+	for (auto& promiseWaiter : inFlight.vecWaiters) {
+		promiseWaiter.set_value(response);
+	}
+}
+
+size_t CRequestCoalescer::getInFlightCount() const {
+	std::lock_guard<std::mutex> lock(mutexInFlight);
+	return mapInFlight.size();
+}
@@ -0,0 +1,340 @@
+#include "core/response_cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <functional>
+
+static bool equalsIgnoreCase(std::string_view strLeft, std::string_view strRight) noexcept {
+	return strLeft.size() == strRight.size() && 
+	       std::equal(strLeft.begin(), strLeft.end(), strRight.begin(), [](unsigned char a, unsigned char b) {
+	           return std::tolower(a) == std::tolower(b);
+	       });
+}
+
+static std::string_view trim(std::string_view strInput) noexcept {
+	while (!strInput.empty() && (strInput.front() == ' ' || strInput.front() == '\t')) {
+		strInput.remove_prefix(1);
+	}
+	while (!strInput.empty() && (strInput.back() == ' ' || strInput.back() == '\t')) {
+		strInput.remove_suffix(1);
+	}
+	return strInput;
+}
+
+// the last occurrence wins, earlier ones may belong to redirect hops
+static const std::string* findHeader(const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::string_view strName) noexcept {
+	for (auto it = vecHeaders.rbegin(); it != vecHeaders.rend(); ++it) {
+		if (equalsIgnoreCase(it->first, strName)) {
+			return &it->second;
+		}
+	}
+	return nullptr;
+}
+
+static bool hasDirective(std::string_view strCacheControl, std::string_view strDirective, long long* pValue = nullptr) noexcept {
+	while (!strCacheControl.empty()) {
+		size_t iComma = strCacheControl.find(',');
+		std::string_view strToken = trim(strCacheControl.substr(0, iComma));
+		strCacheControl = iComma == std::string_view::npos ? std::string_view{} : strCacheControl.substr(iComma + 1);
+		
+		size_t iEquals = strToken.find('=');
+		if (!equalsIgnoreCase(trim(strToken.substr(0, iEquals)), strDirective)) {
+			continue;
+		}
+		
+		if (pValue) {
+			if (iEquals == std::string_view::npos) {
+				return false;
+			}
+			std::string_view strValue = trim(strToken.substr(iEquals + 1));
+			if (strValue.size() >= 2 && strValue.front() == '"' && strValue.back() == '"') {
+				strValue = strValue.substr(1, strValue.size() - 2);
+			}
+			auto result = std::from_chars(strValue.data(), strValue.data() + strValue.size(), *pValue);
+			return result.ec == std::errc{};
+		}
+		return true;
+	}
+	return false;
+}
+
+static bool isCacheableStatus(unsigned int iStatusCode) noexcept {
+	return iStatusCode == 200 || iStatusCode == 203 || iStatusCode == 301 || 
+	       iStatusCode == 404 || iStatusCode == 410;
+}
+
+static bool hasValidators(const Response& response) noexcept {
+	return findHeader(response.vecHeaders, "ETag") || findHeader(response.vecHeaders, "Last-Modified");
+}
+
+// returns false when the response must not be stored at all
+static bool computeExpiry(const Response& response, std::chrono::steady_clock::time_point& timeExpires) {
+	if (!isCacheableStatus(response.iStatusCode)) {
+		return false;
+	}
+	
+	std::string strCacheControl;
+	for (const auto& header : response.vecHeaders) {
+		if (equalsIgnoreCase(header.first, "Cache-Control")) {
+			strCacheControl.append(header.second).append(1, ',');
+		}
+	}
+	
+	if (hasDirective(strCacheControl, "no-store")) {
+		return false;
+	}
+	
+	time_t timeNow = std::time(nullptr);
+	const std::string* pDate = findHeader(response.vecHeaders, "Date");
+	time_t timeDate = pDate ? curl_getdate(pDate->c_str(), nullptr) : -1;
+	if (timeDate < 0) {
+		timeDate = timeNow;
+	}
+	
+	bool bExplicit = true;
+	long long iLifetime = 0;
+	if (hasDirective(strCacheControl, "no-cache")) {
+		iLifetime = 0;
+	} else if (hasDirective(strCacheControl, "max-age", &iLifetime)) {
+	} else if (const std::string* pExpires = findHeader(response.vecHeaders, "Expires")) {
+		time_t timeExpiresAt = curl_getdate(pExpires->c_str(), nullptr);
+		iLifetime = timeExpiresAt < 0 ? 0 : static_cast<long long>(timeExpiresAt - timeDate);
+	} else {
+		bExplicit = false;
+	}
+	
+	if (!bExplicit && !hasValidators(response)) {
+		return false;
+	}
+	
+	long long iAge = std::max<long long>(0, timeNow - timeDate);
+	if (const std::string* pAge = findHeader(response.vecHeaders, "Age")) {
+		long long iAgeHeader = 0;
+		if (std::from_chars(pAge->data(), pAge->data() + pAge->size(), iAgeHeader).ec == std::errc{}) {
+			iAge = std::max(iAge, iAgeHeader);
+		}
+	}
+	
+	long long iRemaining = std::max<long long>(0, iLifetime - iAge);
+	timeExpires = std::chrono::steady_clock::now() + std::chrono::seconds(iRemaining);
+	return true;
+}
+
+static size_t estimateBytes(const std::string& strKey, const Response& response) noexcept {
+	size_t iBytes = strKey.size() * 2 + response.strBody.size();
+	for (const auto& header : response.vecHeaders) {
+		iBytes += header.first.size() + header.second.size();
+	}
+	return iBytes;
+}
+
+CResponseCache::CResponseCache(size_t iMaxBytes) : iMaxBytes(iMaxBytes) {
+}
+
+void CResponseCache::setMaxBytes(size_t iMaxBytes) {
+	this->iMaxBytes.store(iMaxBytes, std::memory_order_relaxed);
+	
+	size_t iShardBudget = iMaxBytes / SHARD_COUNT;
+	for (auto& shard : arrShards) {
+		std::lock_guard<std::mutex> lock(shard.mutexShard);
+		while (!shard.listEntries.empty() && shard.iBytes > iShardBudget) {
+			evictLocked(shard, std::prev(shard.listEntries.end()));
+			iEvictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+bool CResponseCache::isCacheableRequest(const std::vector<std::pair<std::string, std::string>>& vecHeaders) noexcept {
+	for (const auto& header : vecHeaders) {
+		if (equalsIgnoreCase(header.first, "Range") || 
+		    equalsIgnoreCase(header.first, "If-None-Match") || 
+		    equalsIgnoreCase(header.first, "If-Modified-Since")) {
+			return false;
+		}
+		if (equalsIgnoreCase(header.first, "Cache-Control") && 
+		    (hasDirective(header.second, "no-store") || hasDirective(header.second, "no-cache"))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+CResponseCache::Shard& CResponseCache::getShard(const std::string& strKey) noexcept {
+	return arrShards[std::hash<std::string>{}(strKey) % SHARD_COUNT];
+}
+
+void CResponseCache::evictLocked(Shard& shard, std::list<Entry>::iterator itEntry) {
+	shard.iBytes -= itEntry->iBytes;
+	shard.mapEntries.erase(itEntry->strKey);
+	shard.listEntries.erase(itEntry);
+}
+
+CResponseCache::LookupResult CResponseCache::lookup(const std::string& strKey, const std::vector<std::pair<std::string, std::string>>& vecHeaders, std::shared_ptr<const Response>& pCached) {
+	Shard& shard = getShard(strKey);
+	std::lock_guard<std::mutex> lock(shard.mutexShard);
+	
+	auto it = shard.mapEntries.find(strKey);
+	if (it == shard.mapEntries.end()) {
+		iMisses.fetch_add(1, std::memory_order_relaxed);
+		return LookupResult::Miss;
+	}
+	
+	auto itEntry = it->second;
+	for (const auto& vary : itEntry->vecVary) {
+		const std::string* pValue = findHeader(vecHeaders, vary.first);
+		if ((pValue ? *pValue : std::string()) != vary.second) {
+			iMisses.fetch_add(1, std::memory_order_relaxed);
+			return LookupResult::Miss;
+		}
+	}
+	
+	shard.listEntries.splice(shard.listEntries.begin(), shard.listEntries, itEntry);
+	pCached = itEntry->pResponse;
+	
+	if (std::chrono::steady_clock::now() < itEntry->timeExpires) {
+		iHits.fetch_add(1, std::memory_order_relaxed);
+		return LookupResult::Fresh;
+	}
+	
+	if (hasValidators(*pCached)) {
+		return LookupResult::Stale;
+	}
+	
+	pCached.reset();
+	evictLocked(shard, itEntry);
+	iMisses.fetch_add(1, std::memory_order_relaxed);
+	return LookupResult::Miss;
+}
+
+void CResponseCache::addValidators(const Response& responseCached, std::vector<std::pair<std::string, std::string>>& vecHeaders) {
+	if (const std::string* pETag = findHeader(responseCached.vecHeaders, "ETag")) {
+		vecHeaders.emplace_back("If-None-Match", *pETag);
+	}
+	if (const std::string* pLastModified = findHeader(responseCached.vecHeaders, "Last-Modified")) {
+		vecHeaders.emplace_back("If-Modified-Since", *pLastModified);
+	}
+}
+
+void CResponseCache::attach(const std::string& strKey, Request& request, std::shared_ptr<const Response> pStale) {
+	auto fnPrevious = std::move(request.fnOnComplete);
+	request.fnOnComplete = [this, strKey, pStale = std::move(pStale), fnPrevious = std::move(fnPrevious)](const Request& requestDone, Response& response) {
+		if (pStale) {
+			if (response.iStatusCode == 304) {
+				revalidated(strKey, requestDone.getHeaders(), *pStale, response);
+			} else {
+				iMisses.fetch_add(1, std::memory_order_relaxed);
+				store(strKey, requestDone.getHeaders(), response);
+			}
+		} else {
+			store(strKey, requestDone.getHeaders(), response);
+		}
+		
+		if (fnPrevious) {
+			fnPrevious(requestDone, response);
+		}
+	};
+}
+
+void CResponseCache::revalidated(const std::string& strKey, const std::vector<std::pair<std::string, std::string>>& vecRequestHeaders, const Response& responseStale, Response& response) {
+	Response responseMerged = responseStale;
+	responseMerged.timeRequestTime = response.timeRequestTime;
+	responseMerged.timeResponseTime = response.timeResponseTime;
+	responseMerged.bFromCache = true;
+	
+	for (const auto& header : response.vecHeaders) {
+		auto it = std::find_if(responseMerged.vecHeaders.begin(), responseMerged.vecHeaders.end(), [&header](const auto& existing) {
+			return equalsIgnoreCase(existing.first, header.first);
+		});
+		if (it != responseMerged.vecHeaders.end()) {
+			it->second = header.second;
+		} else {
+			responseMerged.vecHeaders.push_back(header);
+		}
+	}
+	
+	response = std::move(responseMerged);
+	iRevalidations.fetch_add(1, std::memory_order_relaxed);
+	store(strKey, vecRequestHeaders, response);
+}
+
+void CResponseCache::store(const std::string& strKey, const std::vector<std::pair<std::string, std::string>>& vecRequestHeaders, const Response& response) {
+	size_t iShardBudget = iMaxBytes.load(std::memory_order_relaxed) / SHARD_COUNT;
+	
+	Entry entry;
+	if (!computeExpiry(response, entry.timeExpires)) {
+		return;
+	}
+	
+	if (const std::string* pVary = findHeader(response.vecHeaders, "Vary")) {
+		std::string_view strVary = *pVary;
+		while (!strVary.empty()) {
+			size_t iComma = strVary.find(',');
+			std::string_view strName = trim(strVary.substr(0, iComma));
+			strVary = iComma == std::string_view::npos ? std::string_view{} : strVary.substr(iComma + 1);
+			
+			if (strName == "*") {
+				return;
+			}
+			if (!strName.empty()) {
+				const std::string* pValue = findHeader(vecRequestHeaders, strName);
+				entry.vecVary.emplace_back(std::string(strName), pValue ? *pValue : std::string());
+			}
+		}
+	}
+	
+	entry.iBytes = estimateBytes(strKey, response) + ENTRY_OVERHEAD;
+	if (entry.iBytes > iShardBudget) {
+		return;
+	}
+	
+	entry.strKey = strKey;
+	auto pResponse = std::make_shared<Response>(response);
+	pResponse->bFromCache = true;
+	entry.pResponse = std::move(pResponse);
+	
+	Shard& shard = getShard(strKey);
+	std::lock_guard<std::mutex> lock(shard.mutexShard);
+	
+	auto it = shard.mapEntries.find(strKey);
+	if (it != shard.mapEntries.end()) {
+		evictLocked(shard, it->second);
+	}
+	
+	shard.listEntries.push_front(std::move(entry));
+	auto itEntry = shard.listEntries.begin();
+	shard.mapEntries.emplace(itEntry->strKey, itEntry);
+	shard.iBytes += itEntry->iBytes;
+	iStores.fetch_add(1, std::memory_order_relaxed);
+	
+	while (shard.iBytes > iShardBudget && shard.listEntries.size() > 1) {
+		evictLocked(shard, std::prev(shard.listEntries.end()));
+		iEvictions.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void CResponseCache::clear() {
+	for (auto& shard : arrShards) {
+		std::lock_guard<std::mutex> lock(shard.mutexShard);
+		shard.mapEntries.clear();
+		shard.listEntries.clear();
+		shard.iBytes = 0;
+	}
+}
+
+CacheStats CResponseCache::getStats() const {
+	CacheStats stats;
+	stats.iHits = iHits.load(std::memory_order_relaxed);
+	stats.iMisses = iMisses.load(std::memory_order_relaxed);
+	stats.iRevalidations = iRevalidations.load(std::memory_order_relaxed);
+	stats.iStores = iStores.load(std::memory_order_relaxed);
+	stats.iEvictions = iEvictions.load(std::memory_order_relaxed);
+	
+	for (auto& shard : arrShards) {
+		std::lock_guard<std::mutex> lock(shard.mutexShard);
+		stats.iEntries += shard.listEntries.size();
+		stats.iBytes += shard.iBytes;
+	}
+	return stats;
+}
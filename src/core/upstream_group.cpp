@@ -0,0 +1,199 @@
+#include "core/upstream_group.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+CUpstreamEndpoint::CUpstreamEndpoint(std::string strURL) : strURL(std::move(strURL)) {
+	if (this->strURL.starts_with(UNIX_SOCKET_PREFIX)) {
+		strUnixSocket = this->strURL.substr(UNIX_SOCKET_PREFIX.size());
+		this->strURL = "http://localhost";
+	}
+}
+
+CUpstreamGroup::CUpstreamGroup(std::string strName, const std::vector<std::string>& vecEndpointURLs, const UpstreamGroupConfig& config) : strName(std::move(strName)), config(config) {
+	if (vecEndpointURLs.empty()) {
+		throw std::invalid_argument("Upstream group " + this->strName + " has no endpoints");
+	}
+	
+	vecEndpoints.reserve(vecEndpointURLs.size());
+	for (const auto& strURL : vecEndpointURLs) {
+		std::string_view strSpec(strURL);
+		bool bUnixSocket = strSpec.starts_with(CUpstreamEndpoint::UNIX_SOCKET_PREFIX);
+		if (bUnixSocket ? !CUtils::isValidUnixSocketPath(strSpec.substr(CUpstreamEndpoint::UNIX_SOCKET_PREFIX.size())) : !CUtils::isValidUrl(strURL)) {
+			throw std::invalid_argument("Invalid upstream URL: " + strURL);
+		}
+		vecEndpoints.push_back(std::make_unique<CUpstreamEndpoint>(strURL));
+	}
+}
+
+std::int64_t CUpstreamGroup::nowNanos() noexcept {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool CUpstreamGroup::isEjected(const CUpstreamEndpoint& endpoint, std::int64_t iNow) const noexcept {
+	return endpoint.iEjectedUntil.load(std::memory_order_relaxed) > iNow;
+}
+
+double CUpstreamGroup::latencyCost(const CUpstreamEndpoint& endpoint, std::int64_t iNow) const noexcept {
+	// an endpoint without samples is cheap until it has requests in flight,
+	// then it is penalised so one new replica does not soak up everything
+	constexpr double PENALTY_NANOS = 1e9;
+	
+	double dEwma = endpoint.dLatencyEwma.load(std::memory_order_relaxed);
+	std::int64_t iUpdated = endpoint.iLatencyUpdated.load(std::memory_order_relaxed);
+	size_t iOutstanding = endpoint.iOutstanding.load(std::memory_order_relaxed);
+	
+	if (iUpdated == 0) {
+		return iOutstanding == 0 ? 0.0 : PENALTY_NANOS * iOutstanding;
+	}
+	
+	// idle endpoints decay towards zero so a past spike is not held forever
+	double dTau = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(config.timeEwmaDecay).count());
+	if (dTau > 0 && iNow > iUpdated) {
+		dEwma *= std::exp(-static_cast<double>(iNow - iUpdated) / dTau);
+	}
+	
+	return dEwma * static_cast<double>(iOutstanding + 1);
+}
+
+CUpstreamEndpoint& CUpstreamGroup::select() {
+	std::int64_t iNow = nowNanos();
+	size_t iCount = vecEndpoints.size();
+	size_t iStart = iNextEndpoint.fetch_add(1, std::memory_order_relaxed);
+	
+	// when every endpoint is ejected the group fails open and uses all of them
+	bool bAnyHealthy = std::any_of(vecEndpoints.begin(), vecEndpoints.end(), [&](const auto& pEndpoint) {
+		return !isEjected(*pEndpoint, iNow);
+	});
+	auto isCandidate = [&](const CUpstreamEndpoint& endpoint) {
+		return !bAnyHealthy || !isEjected(endpoint, iNow);
+	};
+	
+	CUpstreamEndpoint* pChosen = nullptr;
+	
+	switch (config.ePolicy) {
+		case BalancingPolicy::RoundRobin:
+			for (size_t i = 0; i < iCount && !pChosen; ++i) {
+				CUpstreamEndpoint& endpoint = *vecEndpoints[(iStart + i) % iCount];
+				if (isCandidate(endpoint)) {
+					pChosen = &endpoint;
+				}
+			}
+			break;
+		case BalancingPolicy::PowerOfTwoChoices:
+			if (iCount > 1) {
+				thread_local std::minstd_rand randomEngine(std::random_device{}());
+				size_t iFirst = randomEngine() % iCount;
+				size_t iSecond = randomEngine() % (iCount - 1);
+				if (iSecond >= iFirst) {
+					++iSecond;
+				}
+				
+				CUpstreamEndpoint& first = *vecEndpoints[iFirst];
+				CUpstreamEndpoint& second = *vecEndpoints[iSecond];
+				if (isCandidate(first) && isCandidate(second)) {
+					pChosen = second.iOutstanding.load(std::memory_order_relaxed) < first.iOutstanding.load(std::memory_order_relaxed) ? &second : &first;
+				} else if (isCandidate(first)) {
+					pChosen = &first;
+				} else if (isCandidate(second)) {
+					pChosen = &second;
+				}
+				if (pChosen) {
+					break;
+				}
+			}
+			// both picks ejected, take the least loaded healthy endpoint
+			[[fallthrough]];
+		case BalancingPolicy::LeastOutstanding: {
+			size_t iBest = 0;
+			for (size_t i = 0; i < iCount; ++i) {
+				CUpstreamEndpoint& endpoint = *vecEndpoints[(iStart + i) % iCount];
+				size_t iOutstanding = endpoint.iOutstanding.load(std::memory_order_relaxed);
+				if (isCandidate(endpoint) && (!pChosen || iOutstanding < iBest)) {
+					pChosen = &endpoint;
+					iBest = iOutstanding;
+				}
+			}
+			break;
+		}
+		case BalancingPolicy::PeakEwma: {
+			double dBest = 0.0;
+			for (size_t i = 0; i < iCount; ++i) {
+				CUpstreamEndpoint& endpoint = *vecEndpoints[(iStart + i) % iCount];
+				double dCost = latencyCost(endpoint, iNow);
+				if (isCandidate(endpoint) && (!pChosen || dCost < dBest)) {
+					pChosen = &endpoint;
+					dBest = dCost;
+				}
+			}
+			break;
+		}
+	}
+	
+	if (!pChosen) {
+		pChosen = vecEndpoints[iStart % iCount].get();
+	}
+	
+	pChosen->iOutstanding.fetch_add(1, std::memory_order_relaxed);
+	pChosen->iRequests.fetch_add(1, std::memory_order_relaxed);
+	return *pChosen;
+}
+
+void CUpstreamGroup::release(CUpstreamEndpoint& endpoint, bool bFailed, std::chrono::nanoseconds timeLatency) {
+	endpoint.iOutstanding.fetch_sub(1, std::memory_order_relaxed);
+	std::int64_t iNow = nowNanos();
+	
+	if (bFailed) {
+		endpoint.iFailures.fetch_add(1, std::memory_order_relaxed);
+		size_t iConsecutive = endpoint.iConsecutiveFailures.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (config.iEjectAfterFailures > 0 && iConsecutive >= config.iEjectAfterFailures) {
+			endpoint.iConsecutiveFailures.store(0, std::memory_order_relaxed);
+			endpoint.iEjections.fetch_add(1, std::memory_order_relaxed);
+			endpoint.iEjectedUntil.store(iNow + std::chrono::duration_cast<std::chrono::nanoseconds>(config.timeEjection).count(), std::memory_order_relaxed);
+		}
+	} else {
+		endpoint.iConsecutiveFailures.store(0, std::memory_order_relaxed);
+	}
+	
+	std::lock_guard<std::mutex> lock(endpoint.mutexLatency);
+	
+	double dSample = static_cast<double>(timeLatency.count());
+	double dEwma = endpoint.dLatencyEwma.load(std::memory_order_relaxed);
+	std::int64_t iUpdated = endpoint.iLatencyUpdated.load(std::memory_order_relaxed);
+	
+	// peaks are taken at once, improvements only fade in. a fast failure
+	// (refused connection) must not make an endpoint look attractive
+	if (iUpdated == 0) {
+		dEwma = dSample;
+	} else if (dSample > dEwma) {
+		dEwma = dSample;
+	} else if (!bFailed) {
+		double dTau = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(config.timeEwmaDecay).count());
+		double dWeight = dTau > 0 ? std::exp(-static_cast<double>(std::max<std::int64_t>(iNow - iUpdated, 0)) / dTau) : 0.0;
+		dEwma = dEwma * dWeight + dSample * (1.0 - dWeight);
+	}
+	
+	endpoint.dLatencyEwma.store(dEwma, std::memory_order_relaxed);
+	endpoint.iLatencyUpdated.store(iNow, std::memory_order_relaxed);
+}
+
+std::vector<UpstreamEndpointStats> CUpstreamGroup::getStats() const {
+	std::int64_t iNow = nowNanos();
+	
+	std::vector<UpstreamEndpointStats> vecStats;
+	vecStats.reserve(vecEndpoints.size());
+	for (const auto& pEndpoint : vecEndpoints) {
+		UpstreamEndpointStats stats;
+		stats.strURL = pEndpoint->strURL;
+		stats.iOutstanding = pEndpoint->iOutstanding.load(std::memory_order_relaxed);
+		stats.iRequests = pEndpoint->iRequests.load(std::memory_order_relaxed);
+		stats.iFailures = pEndpoint->iFailures.load(std::memory_order_relaxed);
+		stats.iEjections = pEndpoint->iEjections.load(std::memory_order_relaxed);
+		stats.dLatencyEwmaMs = pEndpoint->dLatencyEwma.load(std::memory_order_relaxed) / 1e6;
+		stats.bEjected = isEjected(*pEndpoint, iNow);
+		vecStats.push_back(std::move(stats));
+	}
+	return vecStats;
+}
@@ -0,0 +1,445 @@
+#include "core/warm_start.hpp"
+#include "core/dns_cache.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'H', 'C', 'W', 'S'};
+constexpr std::uint8_t SNAPSHOT_VERSION = 1;
+
+// each section is a tag and a byte length, readers skip tags they do not know
+enum : std::uint8_t {
+	SECTION_DNS = 1,
+	SECTION_HSTS = 2,
+	SECTION_TLS = 3
+};
+
+void putU8(std::string& strOut, std::uint8_t iValue) {
+	strOut.push_back(static_cast<char>(iValue));
+}
+
+void putU32(std::string& strOut, std::uint32_t iValue) {
+	for (int i = 0; i < 4; ++i) {
+		strOut.push_back(static_cast<char>((iValue >> (i * 8)) & 0xFF));
+	}
+}
+
+void putU64(std::string& strOut, std::uint64_t iValue) {
+	for (int i = 0; i < 8; ++i) {
+		strOut.push_back(static_cast<char>((iValue >> (i * 8)) & 0xFF));
+	}
+}
+
+void putString(std::string& strOut, std::string_view str) {
+	putU32(strOut, static_cast<std::uint32_t>(str.size()));
+	strOut.append(str);
+}
+
+void putSection(std::string& strOut, std::uint8_t iTag, const std::string& strPayload) {
+	putU8(strOut, iTag);
+	putString(strOut, strPayload);
+}
+
+// bounds-checked cursor, every read fails once the input runs short
+class CSnapshotReader {
+ public:
+	explicit CSnapshotReader(std::string_view strInput) noexcept : strInput(strInput) {}
+	
+	bool readU8(std::uint8_t& iValue) noexcept {
+		if (strInput.empty()) {
+			return false;
+		}
+		iValue = static_cast<std::uint8_t>(strInput.front());
+		strInput.remove_prefix(1);
+		return true;
+	}
+	
+	bool readU32(std::uint32_t& iValue) noexcept {
+		if (strInput.size() < 4) {
+			return false;
+		}
+		iValue = 0;
+		for (int i = 0; i < 4; ++i) {
+			iValue |= static_cast<std::uint32_t>(static_cast<unsigned char>(strInput[i])) << (i * 8);
+		}
+		strInput.remove_prefix(4);
+		return true;
+	}
+	
+	bool readU64(std::uint64_t& iValue) noexcept {
+		if (strInput.size() < 8) {
+			return false;
+		}
+		iValue = 0;
+		for (int i = 0; i < 8; ++i) {
+			iValue |= static_cast<std::uint64_t>(static_cast<unsigned char>(strInput[i])) << (i * 8);
+		}
+		strInput.remove_prefix(8);
+		return true;
+	}
+	
+	bool readView(std::string_view& strValue) noexcept {
+		std::uint32_t iLength = 0;
+		if (!readU32(iLength) || strInput.size() < iLength) {
+			return false;
+		}
+		strValue = strInput.substr(0, iLength);
+		strInput.remove_prefix(iLength);
+		return true;
+	}
+	
+	bool readString(std::string& strValue) {
+		std::string_view strView;
+		if (!readView(strView)) {
+			return false;
+		}
+		strValue.assign(strView);
+		return true;
+	}
+	
+	bool empty() const noexcept { return strInput.empty(); }
+	
+ private:
+	std::string_view strInput;
+};
+
+bool readFile(const std::string& strPath, std::string& strContents) {
+	int iFd = ::open(strPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (iFd < 0) {
+		return false;
+	}
+	
+	char arrBuffer[16 * 1024];
+	ssize_t iRead;
+	while ((iRead = ::read(iFd, arrBuffer, sizeof(arrBuffer))) != 0) {
+		if (iRead < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			::close(iFd);
+			return false;
+		}
+		strContents.append(arrBuffer, static_cast<size_t>(iRead));
+	}
+	
+	::close(iFd);
+	return true;
+}
+
+// the snapshot holds tls session secrets, so it is only readable by the owner
+bool writeFileAtomically(const std::string& strPath, std::string_view strContents) {
+	std::string strTemporary = strPath + ".tmp";
+	int iFd = ::open(strTemporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (iFd < 0) {
+		return false;
+	}
+	
+	while (!strContents.empty()) {
+		ssize_t iWritten = ::write(iFd, strContents.data(), strContents.size());
+		if (iWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			::close(iFd);
+			::unlink(strTemporary.c_str());
+			return false;
+		}
+		strContents.remove_prefix(static_cast<size_t>(iWritten));
+	}
+	
+	if (::close(iFd) != 0 || ::rename(strTemporary.c_str(), strPath.c_str()) != 0) {
+		::unlink(strTemporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+}  // namespace
+
+CWarmStartState::CWarmStartState(bool bPersistent) : bPersistent(bPersistent) {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	
+	pShare = curl_share_init();
+	if (!pShare) {
+		return;
+	}
+	
+	curl_share_setopt(pShare, CURLSHOPT_LOCKFUNC, lockShare);
+	curl_share_setopt(pShare, CURLSHOPT_UNLOCKFUNC, unlockShare);
+	curl_share_setopt(pShare, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	
+	// a shared hsts cache only exists since 7.88, and without a snapshot it
+	// would change how plain http urls behave for no gain
+#if LIBCURL_VERSION_NUM >= 0x075800
+	if (bPersistent) {
+		curl_share_setopt(pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_HSTS);
+	}
+#endif
+}
+
+CWarmStartState::~CWarmStartState() {
+	if (pShare) {
+		curl_share_cleanup(pShare);
+	}
+	curl_global_cleanup();
+}
+
+void CWarmStartState::lockShare(CURL*, curl_lock_data eData, curl_lock_access, void* pUser) {
+	auto* pState = static_cast<CWarmStartState*>(pUser);
+	pState->arrShareLocks[static_cast<size_t>(eData) % CURL_LOCK_DATA_LAST].lock();
+}
+
+void CWarmStartState::unlockShare(CURL*, curl_lock_data eData, void* pUser) {
+	auto* pState = static_cast<CWarmStartState*>(pUser);
+	pState->arrShareLocks[static_cast<size_t>(eData) % CURL_LOCK_DATA_LAST].unlock();
+}
+
+CURLSTScode CWarmStartState::readHsts(CURL*, curl_hstsentry* pEntry, void* pUser) {
+	auto* pState = static_cast<CWarmStartState*>(pUser);
+	
+	while (pState->iHstsCursor < pState->vecHsts.size()) {
+		const HstsEntry& entry = pState->vecHsts[pState->iHstsCursor++];
+		if (entry.strHost.size() >= pEntry->namelen || entry.strExpire.size() >= sizeof(pEntry->expire)) {
+			continue;
+		}
+		
+		std::memcpy(pEntry->name, entry.strHost.c_str(), entry.strHost.size() + 1);
+		std::memcpy(pEntry->expire, entry.strExpire.c_str(), entry.strExpire.size() + 1);
+		pEntry->includeSubDomains = entry.bIncludeSubDomains ? 1 : 0;
+		pState->iHstsRestored.fetch_add(1, std::memory_order_relaxed);
+		return CURLSTS_OK;
+	}
+	return CURLSTS_DONE;
+}
+
+CURLSTScode CWarmStartState::writeHsts(CURL*, curl_hstsentry* pEntry, curl_index*, void* pUser) {
+	auto* pState = static_cast<CWarmStartState*>(pUser);
+	pState->vecHsts.push_back(HstsEntry{pEntry->name, pEntry->expire, pEntry->includeSubDomains != 0});
+	return CURLSTS_OK;
+}
+
+void CWarmStartState::importHsts() {
+#if LIBCURL_VERSION_NUM >= 0x075800
+	CURL* pHandle = curl_easy_init();
+	if (!pHandle) {
+		return;
+	}
+	
+	// curl pulls hsts entries when a transfer starts, a malformed url gets that
+	// far without touching the network and leaves them in the shared cache
+	iHstsCursor = 0;
+	curl_easy_setopt(pHandle, CURLOPT_SHARE, pShare);
+	curl_easy_setopt(pHandle, CURLOPT_HSTS_CTRL, static_cast<long>(CURLHSTS_ENABLE));
+	curl_easy_setopt(pHandle, CURLOPT_HSTSREADFUNCTION, readHsts);
+	curl_easy_setopt(pHandle, CURLOPT_HSTSREADDATA, this);
+	curl_easy_setopt(pHandle, CURLOPT_URL, "http://");
+	curl_easy_perform(pHandle);
+	curl_easy_cleanup(pHandle);
+#endif
+	vecHsts.clear();
+}
+
+void CWarmStartState::exportHsts() {
+	vecHsts.clear();
+#if LIBCURL_VERSION_NUM >= 0x075800
+	CURL* pHandle = curl_easy_init();
+	if (!pHandle) {
+		return;
+	}
+	
+	// curl hands every hsts entry to the write callback when a handle closes
+	curl_easy_setopt(pHandle, CURLOPT_SHARE, pShare);
+	curl_easy_setopt(pHandle, CURLOPT_HSTS_CTRL, static_cast<long>(CURLHSTS_ENABLE));
+	curl_easy_setopt(pHandle, CURLOPT_HSTSWRITEFUNCTION, writeHsts);
+	curl_easy_setopt(pHandle, CURLOPT_HSTSWRITEDATA, this);
+	curl_easy_cleanup(pHandle);
+#endif
+}
+
+// session import and export arrived in 8.12. older versions still resume
+// sessions across handles through the share, but a restart starts cold
+void CWarmStartState::importTlsSessions() {
+#if LIBCURL_VERSION_NUM >= 0x080c00
+	CURL* pHandle = curl_easy_init();
+	if (pHandle) {
+		curl_easy_setopt(pHandle, CURLOPT_SHARE, pShare);
+		for (const auto& session : vecTlsSessions) {
+			CURLcode res = curl_easy_ssls_import(pHandle,
+				session.strKey.empty() ? nullptr : session.strKey.c_str(),
+				reinterpret_cast<const unsigned char*>(session.strMac.data()), session.strMac.size(),
+				reinterpret_cast<const unsigned char*>(session.strData.data()), session.strData.size());
+			if (res == CURLE_OK) {
+				iTlsRestored.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		curl_easy_cleanup(pHandle);
+	}
+#endif
+	vecTlsSessions.clear();
+}
+
+void CWarmStartState::exportTlsSessions() {
+	vecTlsSessions.clear();
+#if LIBCURL_VERSION_NUM >= 0x080c00
+	CURL* pHandle = curl_easy_init();
+	if (!pHandle) {
+		return;
+	}
+	
+	curl_easy_setopt(pHandle, CURLOPT_SHARE, pShare);
+	curl_easy_ssls_export(pHandle,
+		+[](CURL*, void* pUser, const char* pKey, const unsigned char* pMac, size_t iMacLength,
+		    const unsigned char* pData, size_t iDataLength, curl_off_t, int, const char*, size_t) -> CURLcode {
+			auto* pSessions = static_cast<std::vector<TlsSession>*>(pUser);
+			pSessions->push_back(TlsSession{
+				pKey ? std::string(pKey) : std::string(),
+				std::string(reinterpret_cast<const char*>(pMac), iMacLength),
+				std::string(reinterpret_cast<const char*>(pData), iDataLength)
+			});
+			return CURLE_OK;
+		}, &vecTlsSessions);
+	curl_easy_cleanup(pHandle);
+#endif
+}
+
+bool CWarmStartState::load(const std::string& strPath, CDnsCache& dnsCache) {
+	std::lock_guard<std::mutex> lock(mutexSnapshot);
+	
+	std::string strContents;
+	if (!pShare || !readFile(strPath, strContents) || strContents.size() < sizeof(SNAPSHOT_MAGIC) + 1 ||
+	    std::memcmp(strContents.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+	    static_cast<std::uint8_t>(strContents[sizeof(SNAPSHOT_MAGIC)]) != SNAPSHOT_VERSION) {
+		return false;
+	}
+	
+	std::vector<DnsSnapshotEntry> vecDns;
+	CSnapshotReader reader(std::string_view(strContents).substr(sizeof(SNAPSHOT_MAGIC) + 1));
+	
+	// a section that does not parse is dropped whole, the others still apply
+	while (!reader.empty()) {
+		std::uint8_t iTag = 0;
+		std::string_view strPayload;
+		if (!reader.readU8(iTag) || !reader.readView(strPayload)) {
+			break;
+		}
+		
+		CSnapshotReader section(strPayload);
+		std::uint32_t iCount = 0;
+		if (!section.readU32(iCount)) {
+			continue;
+		}
+		
+		bool bValid = true;
+		if (iTag == SECTION_DNS) {
+			std::vector<DnsSnapshotEntry> vecSection;
+			for (std::uint32_t i = 0; i < iCount && bValid; ++i) {
+				DnsSnapshotEntry entry;
+				std::uint64_t iExpiresMs = 0;
+				std::uint32_t iAddresses = 0;
+				bValid = section.readString(entry.strHost) && section.readU64(iExpiresMs) && section.readU32(iAddresses);
+				for (std::uint32_t j = 0; j < iAddresses && bValid; ++j) {
+					bValid = section.readString(entry.vecAddresses.emplace_back());
+				}
+				entry.timeExpires = std::chrono::system_clock::time_point(std::chrono::milliseconds(static_cast<std::int64_t>(iExpiresMs)));
+				vecSection.push_back(std::move(entry));
+			}
+			if (bValid) {
+				vecDns = std::move(vecSection);
+			}
+		} else if (iTag == SECTION_HSTS) {
+			std::vector<HstsEntry> vecSection;
+			for (std::uint32_t i = 0; i < iCount && bValid; ++i) {
+				HstsEntry entry;
+				std::uint8_t iIncludeSubDomains = 0;
+				bValid = section.readString(entry.strHost) && section.readString(entry.strExpire) && section.readU8(iIncludeSubDomains);
+				entry.bIncludeSubDomains = iIncludeSubDomains != 0;
+				vecSection.push_back(std::move(entry));
+			}
+			if (bValid) {
+				vecHsts = std::move(vecSection);
+			}
+		} else if (iTag == SECTION_TLS) {
+			std::vector<TlsSession> vecSection;
+			for (std::uint32_t i = 0; i < iCount && bValid; ++i) {
+				TlsSession session;
+				bValid = section.readString(session.strKey) && section.readString(session.strMac) && section.readString(session.strData);
+				vecSection.push_back(std::move(session));
+			}
+			if (bValid) {
+				vecTlsSessions = std::move(vecSection);
+			}
+		}
+	}
+	
+	iDnsRestored.store(dnsCache.importEntries(vecDns), std::memory_order_relaxed);
+	importHsts();
+	importTlsSessions();
+	
+	WarmStartStats stats = getStats();
+	return stats.iDnsEntries + stats.iHstsEntries + stats.iTlsSessions > 0;
+}
+
+bool CWarmStartState::save(const std::string& strPath, const CDnsCache& dnsCache) {
+	std::lock_guard<std::mutex> lock(mutexSnapshot);
+	if (!pShare || !bPersistent) {
+		return false;
+	}
+	
+	std::string strSnapshot(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	putU8(strSnapshot, SNAPSHOT_VERSION);
+	
+	std::string strSection;
+	auto vecDns = dnsCache.exportEntries();
+	putU32(strSection, static_cast<std::uint32_t>(vecDns.size()));
+	for (const auto& entry : vecDns) {
+		putString(strSection, entry.strHost);
+		putU64(strSection, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(entry.timeExpires.time_since_epoch()).count()));
+		putU32(strSection, static_cast<std::uint32_t>(entry.vecAddresses.size()));
+		for (const auto& strAddress : entry.vecAddresses) {
+			putString(strSection, strAddress);
+		}
+	}
+	putSection(strSnapshot, SECTION_DNS, strSection);
+	
+	exportHsts();
+	strSection.clear();
+	putU32(strSection, static_cast<std::uint32_t>(vecHsts.size()));
+	for (const auto& entry : vecHsts) {
+		putString(strSection, entry.strHost);
+		putString(strSection, entry.strExpire);
+		putU8(strSection, entry.bIncludeSubDomains ? 1 : 0);
+	}
+	putSection(strSnapshot, SECTION_HSTS, strSection);
+	vecHsts.clear();
+	
+	exportTlsSessions();
+	if (!vecTlsSessions.empty()) {
+		strSection.clear();
+		putU32(strSection, static_cast<std::uint32_t>(vecTlsSessions.size()));
+		for (const auto& session : vecTlsSessions) {
+			putString(strSection, session.strKey);
+			putString(strSection, session.strMac);
+			putString(strSection, session.strData);
+		}
+		putSection(strSnapshot, SECTION_TLS, strSection);
+		vecTlsSessions.clear();
+	}
+	
+	return writeFileAtomically(strPath, strSnapshot);
+}
+
+WarmStartStats CWarmStartState::getStats() const noexcept {
+	WarmStartStats stats;
+	stats.iDnsEntries = iDnsRestored.load(std::memory_order_relaxed);
+	stats.iHstsEntries = iHstsRestored.load(std::memory_order_relaxed);
+	stats.iTlsSessions = iTlsRestored.load(std::memory_order_relaxed);
+	return stats;
+}
@@ -62,6 +62,67 @@ std::string CUtils::buildUrl(std::string_view strBase, std::string_view strEndpo
 	return strResult;
 }
 
+std::string_view CUtils::extractHost(std::string_view strUrl) noexcept {
+	size_t iProtocolPos = strUrl.find("://");
+	if (iProtocolPos == std::string_view::npos) {
+		return {};
+	}
+	
+	size_t iHostStart = iProtocolPos + 3;
+	size_t iPathStart = strUrl.find('/', iHostStart);
+	
+	return strUrl.substr(iHostStart, iPathStart == std::string_view::npos ? std::string_view::npos : iPathStart - iHostStart);
+}
+
+// host part of the authority, without credentials, port or ipv6 brackets
+std::string_view CUtils::extractHostName(std::string_view strUrl) noexcept {
+	std::string_view strAuthority = extractHost(strUrl);
+	strAuthority = strAuthority.substr(0, strAuthority.find_first_of("?#"));
+	
+	size_t iAtPos = strAuthority.rfind('@');
+	if (iAtPos != std::string_view::npos) {
+		strAuthority.remove_prefix(iAtPos + 1);
+	}
+	
+	if (!strAuthority.empty() && strAuthority.front() == '[') {
+		size_t iClose = strAuthority.find(']');
+		return iClose == std::string_view::npos ? std::string_view() : strAuthority.substr(1, iClose - 1);
+	}
+	return strAuthority.substr(0, strAuthority.find(':'));
+}
+
+// explicit port of the url, otherwise the scheme default. 0 when neither
+std::uint16_t CUtils::extractPort(std::string_view strUrl) noexcept {
+	std::string_view strAuthority = extractHost(strUrl);
+	strAuthority = strAuthority.substr(0, strAuthority.find_first_of("?#"));
+	
+	size_t iAtPos = strAuthority.rfind('@');
+	if (iAtPos != std::string_view::npos) {
+		strAuthority.remove_prefix(iAtPos + 1);
+	}
+	
+	size_t iColonPos = strAuthority.rfind(':');
+	size_t iBracketPos = strAuthority.rfind(']');
+	if (iColonPos != std::string_view::npos && (iBracketPos == std::string_view::npos || iColonPos > iBracketPos)) {
+		unsigned int iPort = 0;
+		for (char c : strAuthority.substr(iColonPos + 1)) {
+			if (c < '0' || c > '9' || iPort > 65535) {
+				return 0;
+			}
+			iPort = iPort * 10 + static_cast<unsigned int>(c - '0');
+		}
+		return iPort <= 65535 ? static_cast<std::uint16_t>(iPort) : 0;
+	}
+	
+	if (strUrl.substr(0, 8) == "https://") {
+		return 443;
+	}
+	if (strUrl.substr(0, 7) == "http://") {
+		return 80;
+	}
+	return 0;
+}
+
 std::vector<std::pair<std::string, std::string>> CUtils::parseHeaders(std::string_view strHeaderString) {
 	std::vector<std::pair<std::string, std::string>> vecHeaders;
 	std::istringstream ssStream{std::string(strHeaderString)};
@@ -142,6 +203,14 @@ bool CUtils::isValidHeader(std::string_view strHeaderName, std::string_view strH
 	return isValidHeaderName(strHeaderName) && isValidHeaderValue(strHeaderValue);
 }
 
+bool CUtils::isValidUnixSocketPath(std::string_view strPath) noexcept {
+	// sun_path holds 108 bytes, the terminator or the abstract marker takes one
+	if (strPath.empty() || strPath == "@" || strPath.length() > MAX_UNIX_SOCKET_PATH_LENGTH) {
+		return false;
+	}
+	return strPath.find('\0') == std::string_view::npos;
+}
+
 bool CUtils::isValidRequestSize(size_t iSize) noexcept {
 	return iSize <= MAX_REQUEST_BODY_SIZE;
 }